@@ -0,0 +1,254 @@
+/**
+ * @file control.c
+ * @brief Implementation of the fixed-rate motor control tick
+ * @author Kevin Thomas
+ * @date 2025
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Kevin Thomas
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "control.h"
+#include "robot.h"
+#include "probe.h"
+#include "recorder.h"
+#include "ramfunc.h"
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+
+// Repeating alarm driving control_tick()
+static repeating_timer_t control_timer;
+
+// Targets written by control_set_target(), read by the tick
+static volatile int32_t control_target_left;
+static volatile int32_t control_target_right;
+
+// Time of the last valid command
+static volatile uint32_t control_last_cmd_us;
+
+// Ramp limits in duty per tick
+static volatile uint16_t control_accel = CONTROL_ACCEL_DEFAULT;
+static volatile uint16_t control_decel = CONTROL_DECEL_DEFAULT;
+
+// Duty applied during the previous tick
+static int32_t control_left;
+static int32_t control_right;
+
+// Ticks left in the current short brake, then the motors coast
+static volatile uint32_t control_brake_ticks;
+
+// Whether the previous tick held the brake
+static bool control_was_braking;
+
+// Set once the failsafe has fired, cleared by the next command
+static volatile bool control_is_tripped;
+
+// Key event being timed until the outputs change, and the last latency measured
+static volatile uint32_t control_event_us;
+static volatile bool control_event_pending;
+static volatile uint32_t control_latency_us;
+static volatile bool control_latency_ready;
+
+// Scheduler entry the tick reports to, and the time the next tick is due
+static sched_task_t *control_task;
+static uint32_t control_release_us;
+
+int32_t RAM_FUNC(control_slew)(int32_t current, int32_t target, uint16_t accel, uint16_t decel) {
+    // Opposite signs, slow down to zero before reversing
+    if ((current > 0 && target < 0) || (current < 0 && target > 0))
+        target = 0;
+    
+    // Moving toward zero is limited by decel, away from it by accel
+    if (current < target) {
+        int32_t step = (current < 0) ? decel : accel;
+        return (target - current > step) ? current + step : target;
+    } else {
+        int32_t step = (current > 0) ? decel : accel;
+        return (current - target > step) ? current - step : target;
+    }
+}
+
+/**
+ * @brief Control tick run from the hardware alarm every CONTROL_TICK_US.
+ *
+ * @param rt  The repeating timer (unused).
+ * @return bool  Always true to keep the timer running.
+ */
+static bool RAM_FUNC(control_tick)(repeating_timer_t *rt) {
+    (void)rt;
+    uint32_t start_us = time_us_32();
+    PROBE_PERIOD(PROBE_TICK_PERIOD);
+    PROBE_START(tick_start);
+    
+    // Failsafe, brake immediately once the command deadline has passed
+    if (!control_is_tripped && time_us_32() - control_last_cmd_us > CONTROL_FAILSAFE_US) {
+        control_is_tripped = true;
+        control_brake_ticks = CONTROL_BRAKE_MS * 1000 / CONTROL_TICK_US;
+        recorder_failsafe();
+    }
+    
+    // Stay stopped until the next command, even once the 32-bit clock wraps back near it
+    if (control_is_tripped) {
+        control_target_left = 0;
+        control_target_right = 0;
+    }
+    
+    PROBE_START(motor_start);
+    int32_t last_left = control_left, last_right = control_right;
+    bool braking = control_brake_ticks != 0;
+    if (braking) {
+        // Short brake until the brake time runs out
+        control_brake_ticks--;
+        control_left = 0;
+        control_right = 0;
+        motor_brake();
+    } else {
+        // Slew each wheel toward its target; only changed values reach the hardware
+        control_left = control_slew(control_left, control_target_left, control_accel, control_decel);
+        control_right = control_slew(control_right, control_target_right, control_accel, control_decel);
+        motor_drive(control_left, control_right);
+    }
+    PROBE_END(PROBE_MOTOR_SET, motor_start);
+    
+    // Time a stamped key event until this tick changes the outputs, or drop it if none is needed
+    if (control_event_pending) {
+        if (braking != control_was_braking || control_left != last_left || control_right != last_right) {
+            control_latency_us = time_us_32() - control_event_us;
+            control_latency_ready = true;
+            control_event_pending = false;
+            PROBE_RECORD(PROBE_EVENT_LATENCY, control_latency_us);
+        } else if (!braking && control_left == control_target_left && control_right == control_target_right) {
+            control_event_pending = false;
+        }
+    }
+    control_was_braking = braking;
+    
+    PROBE_END(PROBE_CONTROL_TICK, tick_start);
+    
+    // Report to the scheduler table; the alarm keeps ticks on a fixed grid
+    if (control_task) {
+        uint32_t end_us = time_us_32();
+        sched_account(control_task, control_release_us, start_us, end_us);
+        control_release_us += CONTROL_TICK_US;
+        if ((int32_t)(end_us - control_release_us) >= 0) control_release_us = end_us + CONTROL_TICK_US;
+    }
+    return true;
+}
+
+void control_init(sched_task_t *task) {
+    // Start stopped with the deadline already expired
+    control_target_left = 0;
+    control_target_right = 0;
+    control_last_cmd_us = time_us_32() - CONTROL_FAILSAFE_US - 1;
+    control_is_tripped = true;
+    control_brake_ticks = 0;
+    
+    // Negative period keeps ticks evenly spaced regardless of tick duration
+    control_task = task;
+    control_release_us = time_us_32() + CONTROL_TICK_US;
+    add_repeating_timer_us(-CONTROL_TICK_US, control_tick, NULL, &control_timer);
+}
+
+void RAM_FUNC(control_set_target)(int32_t left, int32_t right) {
+    // Update both targets together so the tick never sees half a command
+    uint32_t save = save_and_disable_interrupts();
+    bool changed = left != control_target_left || right != control_target_right;
+    control_target_left = left;
+    control_target_right = right;
+    control_last_cmd_us = time_us_32();
+    control_is_tripped = false;
+    control_brake_ticks = 0;
+    restore_interrupts(save);
+    
+    // Record new targets only; a link streaming the same command adds nothing
+    if (changed) recorder_motor(left, right);
+}
+
+void control_brake(uint32_t brake_ms) {
+    // Zero the target and short-brake for brake_ms before coasting
+    uint32_t save = save_and_disable_interrupts();
+    control_target_left = 0;
+    control_target_right = 0;
+    control_last_cmd_us = time_us_32();
+    control_is_tripped = false;
+    control_brake_ticks = brake_ms * 1000 / CONTROL_TICK_US;
+    restore_interrupts(save);
+    recorder_brake(brake_ms);
+}
+
+void RAM_FUNC(control_feed)(void) {
+    // Restart the failsafe deadline; the targets stay zero if it had already fired
+    control_last_cmd_us = time_us_32();
+    control_is_tripped = false;
+}
+
+void control_set_ramp(uint16_t accel, uint16_t decel) {
+    // Zero would never reach the target
+    control_accel = accel ? accel : 1;
+    control_decel = decel ? decel : 1;
+}
+
+void control_get_applied(int32_t *left, int32_t *right) {
+    // Read both together so they come from the same tick
+    uint32_t save = save_and_disable_interrupts();
+    *left = control_left;
+    *right = control_right;
+    restore_interrupts(save);
+}
+
+bool control_tripped(void) {
+    // Set by the tick, cleared by the next command
+    return control_is_tripped;
+}
+
+bool control_braking(void) {
+    // Counted down by the tick, cleared by a new target
+    return control_brake_ticks != 0;
+}
+
+void control_stamp_event(uint32_t event_us) {
+    // Picked up by the next tick
+    uint32_t save = save_and_disable_interrupts();
+    control_event_us = event_us;
+    control_event_pending = true;
+    restore_interrupts(save);
+}
+
+bool control_take_latency(uint32_t *latency_us) {
+    // Hand over the latency once
+    uint32_t save = save_and_disable_interrupts();
+    bool ready = control_latency_ready;
+    *latency_us = control_latency_us;
+    control_latency_ready = false;
+    restore_interrupts(save);
+    return ready;
+}
+
+bool control_idle(void) {
+    // Targets, applied duty and the last command time from one consistent moment
+    uint32_t save = save_and_disable_interrupts();
+    bool idle = control_target_left == 0 && control_target_right == 0 &&
+                control_left == 0 && control_right == 0 &&
+                (control_is_tripped || time_us_32() - control_last_cmd_us >= CONTROL_IDLE_US);
+    restore_interrupts(save);
+    return idle;
+}
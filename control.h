@@ -0,0 +1,169 @@
+/**
+ * @file control.h
+ * @brief Fixed-rate motor control tick with failsafe and acceleration ramping
+ * @author Kevin Thomas
+ * @date 2025
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Kevin Thomas
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef CONTROL_H
+#define CONTROL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sched.h"
+
+// Control tick period in microseconds (1 kHz)
+#define CONTROL_TICK_US 1000
+
+// Motors are stopped when no command arrives for this long
+#define CONTROL_FAILSAFE_US 800000
+
+// The robot only counts as idle once no command has arrived for this long
+#define CONTROL_IDLE_US 5000
+
+// Short-brake time for a stop or failsafe before the motors coast
+#define CONTROL_BRAKE_MS 200
+
+// Default duty change allowed per tick while speeding up (0 to full in ~330ms)
+#define CONTROL_ACCEL_DEFAULT 200
+
+// Default duty change allowed per tick while slowing down (full to 0 in ~100ms)
+#define CONTROL_DECEL_DEFAULT 650
+
+/**
+ * @brief Start the fixed-rate control tick.
+ *
+ * Installs a repeating hardware alarm that runs every CONTROL_TICK_US on the
+ * calling core. The tick owns the motors: it slews the applied duty of each
+ * wheel toward the target set with control_set_target() and short-brakes the
+ * motors once CONTROL_FAILSAFE_US has passed since the last command.
+ *
+ * @param task  Scheduler entry charged with every tick's run time and
+ *              deadline misses (a tick must end before the next is due), or NULL.
+ */
+void control_init(sched_task_t *task);
+
+/**
+ * @brief Set a new motor target and restart the failsafe deadline.
+ *
+ * @param left   The target duty (-65535 to 65535) for the left motor.
+ * @param right  The target duty (-65535 to 65535) for the right motor.
+ */
+void control_set_target(int32_t left, int32_t right);
+
+/**
+ * @brief Stop now by short-braking, then let the motors coast.
+ *
+ * Counts as a command, so it also restarts the failsafe deadline. Any later
+ * control_set_target() cancels the brake.
+ *
+ * @param brake_ms  How long to hold the short brake, in milliseconds.
+ */
+void control_brake(uint32_t brake_ms);
+
+/**
+ * @brief Restart the failsafe deadline without changing the target.
+ *
+ * Called while a command is still valid, e.g. while a key is held.
+ */
+void control_feed(void);
+
+/**
+ * @brief Change the acceleration and deceleration limits.
+ *
+ * @param accel  Maximum duty increase per tick while speeding up.
+ * @param decel  Maximum duty decrease per tick while slowing down.
+ */
+void control_set_ramp(uint16_t accel, uint16_t decel);
+
+/**
+ * @brief Read the duty applied to each wheel by the last tick.
+ *
+ * @param left   Receives the left duty (-65535 to 65535).
+ * @param right  Receives the right duty (-65535 to 65535).
+ */
+void control_get_applied(int32_t *left, int32_t *right);
+
+/**
+ * @brief Check whether the failsafe has stopped the robot.
+ *
+ * @return bool  true from the failsafe firing until the next command.
+ */
+bool control_tripped(void);
+
+/**
+ * @brief Check whether a short brake is still running.
+ *
+ * @return bool  true from control_brake() or the failsafe firing until the
+ *               brake time runs out or a new target is set.
+ */
+bool control_braking(void);
+
+/**
+ * @brief Time the next change of the motor outputs against a key event.
+ *
+ * The first tick that then writes a new duty or starts a brake records the
+ * time since event_us in PROBE_EVENT_LATENCY and for control_take_latency().
+ * Nothing is recorded if the outputs already match the target, e.g. for a
+ * held key. Call it after acting on the event, so an earlier command still
+ * ramping cannot end the measurement early.
+ *
+ * @param event_us  The time the key event was detected.
+ */
+void control_stamp_event(uint32_t event_us);
+
+/**
+ * @brief Collect the latency measured for the last stamped event.
+ *
+ * @param latency_us  Receives the time from the key event to the outputs changing.
+ * @return bool  true if a new latency was measured since the last call.
+ */
+bool control_take_latency(uint32_t *latency_us);
+
+/**
+ * @brief Check whether the robot is standing still with nothing pending.
+ *
+ * Used to gate work that stalls the cores, such as flash writes.
+ *
+ * @return bool  true if both targets and both applied duties are zero and no
+ *               command has arrived for CONTROL_IDLE_US.
+ */
+bool control_idle(void);
+
+/**
+ * @brief Move a signed duty one tick toward its target.
+ *
+ * Moving away from zero is limited by accel, moving toward zero by decel. A
+ * change of sign first ramps down to zero and only then ramps up the other way.
+ *
+ * @param current  The duty applied during the previous tick.
+ * @param target   The duty being approached.
+ * @param accel    Maximum magnitude increase for this tick.
+ * @param decel    Maximum magnitude decrease for this tick.
+ * @return int32_t The duty to apply for this tick.
+ */
+int32_t control_slew(int32_t current, int32_t target, uint16_t accel, uint16_t decel);
+
+#endif // CONTROL_H
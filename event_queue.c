@@ -0,0 +1,64 @@
+/**
+ * @file event_queue.c
+ * @brief Implementation of the lock-free IR key event queue
+ * @author Kevin Thomas
+ * @date 2025
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Kevin Thomas
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "event_queue.h"
+
+void event_queue_init(event_queue_t *q) {
+    // Start with both indexes at the same slot (empty)
+    atomic_store_explicit(&q->head, 0, memory_order_relaxed);
+    atomic_store_explicit(&q->tail, 0, memory_order_relaxed);
+}
+
+bool event_queue_push(event_queue_t *q, const ir_event_t *ev) {
+    // Only the producer writes head, so a relaxed load is enough
+    unsigned int head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    unsigned int tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+    
+    // Full when the producer is a whole ring ahead of the consumer
+    if (head - tail >= EVENT_QUEUE_SIZE) return false;
+    
+    // Store the event, then publish it by advancing head
+    q->items[head % EVENT_QUEUE_SIZE] = *ev;
+    atomic_store_explicit(&q->head, head + 1, memory_order_release);
+    return true;
+}
+
+bool event_queue_pop(event_queue_t *q, ir_event_t *ev) {
+    // Only the consumer writes tail, so a relaxed load is enough
+    unsigned int tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    unsigned int head = atomic_load_explicit(&q->head, memory_order_acquire);
+    
+    // Empty when the consumer has caught up with the producer
+    if (head == tail) return false;
+    
+    // Copy the event out, then hand the slot back by advancing tail
+    *ev = q->items[tail % EVENT_QUEUE_SIZE];
+    atomic_store_explicit(&q->tail, tail + 1, memory_order_release);
+    return true;
+}
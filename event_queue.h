@@ -0,0 +1,79 @@
+/**
+ * @file event_queue.h
+ * @brief Lock-free single-producer single-consumer queue for IR key events
+ * @author Kevin Thomas
+ * @date 2025
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Kevin Thomas
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef EVENT_QUEUE_H
+#define EVENT_QUEUE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "ir.h"
+
+// Queue capacity, must be a power of two
+#define EVENT_QUEUE_SIZE 16
+
+/**
+ * @brief Fixed-size ring of key events shared between two cores.
+ *
+ * Exactly one producer may push and exactly one consumer may pop. Each side
+ * only writes its own index, so no lock is needed; acquire/release ordering on
+ * the indexes publishes the event data safely across cores.
+ */
+typedef struct {
+    ir_event_t items[EVENT_QUEUE_SIZE];  // Event storage
+    atomic_uint head;                    // Next slot to write, owned by the producer
+    atomic_uint tail;                    // Next slot to read, owned by the consumer
+} event_queue_t;
+
+/**
+ * @brief Empty a queue before either side starts using it.
+ *
+ * @param q  The queue to reset.
+ */
+void event_queue_init(event_queue_t *q);
+
+/**
+ * @brief Append an event to the queue (producer side only).
+ *
+ * @param q   The queue to push to.
+ * @param ev  The event to copy into the queue.
+ * @return bool  true on success, false if the queue is full.
+ */
+bool event_queue_push(event_queue_t *q, const ir_event_t *ev);
+
+/**
+ * @brief Remove the oldest event from the queue (consumer side only).
+ *
+ * @param q   The queue to pop from.
+ * @param ev  Receives the oldest event.
+ * @return bool  true if an event was returned, false if the queue is empty.
+ */
+bool event_queue_pop(event_queue_t *q, ir_event_t *ev);
+
+#endif // EVENT_QUEUE_H
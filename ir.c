@@ -28,112 +28,295 @@
  */
 
 #include "ir.h"
-#include "robot.h"
+#include "control.h"
+#include "motion.h"
+#include "log_ring.h"
+#include "recorder.h"
+#include "probe.h"
+#include "ramfunc.h"
 #include "pico/stdlib.h"
 #include "hardware/gpio.h"
-#include <stdio.h>
+#include "hardware/pio.h"
+#include "hardware/dma.h"
+#include "hardware/sync.h"
+#include "ir_capture.pio.h"
 
-int64_t wait_for_level(unsigned int gpio, bool level, uint32_t timeout_us) {
-    // Record the start time
-    absolute_time_t start = get_absolute_time();
-    
-    // Wait for the GPIO pin to reach the desired level
-    while (gpio_get(gpio) != level) {
-        // Check if timeout has been exceeded
-        if (absolute_time_diff_us(start, get_absolute_time()) > timeout_us)
-            return -1;
-    }
+// Ring buffer size as a power of two, required by the DMA address wrap
+#define IR_RING_BITS  9
+#define IR_RING_WORDS ((1u << IR_RING_BITS) / sizeof(uint32_t))
+
+// Longest sleep once an edge has been seen, covering the few microseconds between the
+// edge interrupt and DMA writing the pulse it ended
+#define IR_WAKE_POLL_US 1000
+
+// Edges that wake a sleeping core: a falling edge starts a frame, the next edge ends the first pulse
+#define IR_WAKE_EDGES (GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE)
+
+// Pulse widths written by DMA, aligned so the write address can wrap
+static uint32_t ir_ring[IR_RING_WORDS] __attribute__((aligned(1u << IR_RING_BITS)));
+
+// DMA channel that drains the PIO RX FIFO into the ring buffer
+static int ir_dma_chan;
+
+// Index of the next ring buffer entry to decode
+static uint32_t ir_read_idx;
+
+// Decoder fed by ir_poll()
+static ir_decoder_t ir_decoder;
+
+// Time ir_poll() last found new edges, to end frames followed by silence
+static uint32_t ir_last_edge_us;
+
+// Key tracking state used by ir_get_event()
+static ir_key_state_t ir_key_state = { -1, 0 };
+
+// Time of the first edge seen while asleep, whether there was one, and the time of the latest
+static volatile uint32_t ir_wake_edge_us;
+static volatile bool ir_wake_edge_seen;
+static volatile uint32_t ir_last_isr_us;
+
+// Set after a wake until the first key event is reported
+static bool ir_awaiting_decode;
+
+// Low-power idle statistics
+static ir_sleep_stats_t ir_sleep_stats;
+
+/**
+ * @brief Find the ring buffer entry DMA will write next.
+ *
+ * @return uint32_t  The write index into ir_ring.
+ */
+static inline uint32_t ir_write_idx(void) {
+    uint32_t write_addr = dma_channel_hw_addr(ir_dma_chan)->write_addr;
+    return (write_addr - (uint32_t)(uintptr_t)ir_ring) / sizeof(uint32_t);
+}
+
+/**
+ * @brief IR_PIN edge interrupt that wakes a sleeping core.
+ *
+ * @param gpio    The GPIO that caused the interrupt (unused).
+ * @param events  The edge events (unused).
+ */
+static void RAM_FUNC(ir_edge_isr)(uint gpio, uint32_t events) {
+    (void)gpio;
+    (void)events;
     
-    // Return the elapsed time in microseconds
-    return absolute_time_diff_us(start, get_absolute_time());
+    // Record the edge and wake the core; stays armed until ir_sleep() disarms it, so the
+    // handler never calls into flash
+    uint32_t now_us = time_us_32();
+    if (!ir_wake_edge_seen) ir_wake_edge_us = now_us;
+    ir_wake_edge_seen = true;
+    ir_last_isr_us = now_us;
+    __sev();
 }
 
-int ir_getkey(void) {
-    // Wait for the leading 9ms low pulse
-    if (wait_for_level(IR_PIN, 0, 150000) < 0) return -1;
+void ir_init(void) {
+    // Initialize IR receiver pin as input with pull-up
+    gpio_init(IR_PIN);
+    gpio_set_dir(IR_PIN, GPIO_IN);
+    gpio_pull_up(IR_PIN);
     
-    // Measure the low pulse duration (should be ~9ms)
-    uint32_t t = wait_for_level(IR_PIN, 1, 12000);
-    if (t < 8000 || t > 10000) return -1;
+    // Load the pulse width capture program on a free state machine
+    PIO pio = pio0;
+    uint offset = pio_add_program(pio, &ir_capture_program);
+    uint sm = pio_claim_unused_sm(pio, true);
     
-    // Wait for the 4.5ms high space
-    t = wait_for_level(IR_PIN, 0, 7000);
-    if (t < 3500 || t > 5000) return -1;
+    // Stream every RX FIFO word into the ring buffer forever
+    ir_dma_chan = dma_claim_unused_channel(true);
+    dma_channel_config c = dma_channel_get_default_config(ir_dma_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, true);
+    channel_config_set_ring(&c, true, IR_RING_BITS);
+    channel_config_set_dreq(&c, pio_get_dreq(pio, sm, false));
+    dma_channel_configure(ir_dma_chan, &c, ir_ring, &pio->rxf[sm],
+                          dma_encode_endless_transfer_count(), true);
     
-    // Initialize data buffer for 4 bytes (32 bits)
-    uint8_t data[4] = {0, 0, 0, 0};
+    // Start measuring pulses only once DMA is ready to collect them
+    ir_decoder_reset(&ir_decoder);
+    ir_read_idx = 0;
+    ir_capture_program_init(pio, sm, offset, IR_PIN);
+}
+
+bool RAM_FUNC(ir_poll)(ir_frame_t *frame) {
+    PROBE_START(poll_start);
     
-    // Read 32 data bits
-    for (int i = 0; i < 32; i++) {
-        // Wait for the 560us low pulse
-        if (wait_for_level(IR_PIN, 1, 1000) < 0) return -1;
-        
-        // Measure the high pulse (560us = '0', 1690us = '1')
-        t = wait_for_level(IR_PIN, 0, 2500);
-        if (t < 200) return -1;
-        
-        // Calculate byte and bit position
-        int idx = i / 8;
-        int bit = i % 8;
+    // Find the ring buffer entry DMA will write next
+    uint32_t write_idx = ir_write_idx();
+    uint32_t now_us = time_us_32();
+    if (ir_read_idx != write_idx) ir_last_edge_us = now_us;
+    
+    // Decode edges until the buffer is empty or a frame completes
+    bool done = false;
+    while (!done && ir_read_idx != write_idx) {
+        uint32_t edge = ir_ring[ir_read_idx];
+        ir_read_idx = (ir_read_idx + 1) % IR_RING_WORDS;
+        recorder_edge(edge);
         
-        // If high pulse is long (>1200us), it's a '1' bit
-        if (t > 1200) {
-            data[idx] |= (1 << bit);
-        }
+        PROBE_START(edge_start);
+        done = ir_decode_edge(&ir_decoder, edge, frame);
+        PROBE_END(PROBE_IR_EDGE, edge_start);
     }
     
-    // Verify address and data checksums (address + ~address = 0xFF, data + ~data = 0xFF)
-    if ((uint8_t)(data[0] + data[1]) == 0xFF && (uint8_t)(data[2] + data[3]) == 0xFF)
-        return data[2];
-        
-    // Invalid checksum
-    return -1;
+    // The closing space is only captured on the next edge, so end a silent frame here
+    if (!done && ir_read_idx == write_idx && !ir_decoder_idle(&ir_decoder) &&
+        now_us - ir_last_edge_us >= IR_GAP_US)
+        done = ir_decode_edge(&ir_decoder, ~(uint32_t)IR_GAP_US, frame);
+    
+    PROBE_END(PROBE_IR_POLL, poll_start);
+    return done;
+}
+
+ir_event_t RAM_FUNC(ir_get_event)(void) {
+    // Decode pending edges and track the key against the current time
+    ir_frame_t frame;
+    bool decoded = ir_poll(&frame);
+    ir_event_t ev = ir_track_key(&ir_key_state, decoded ? &frame : NULL, time_us_32());
+    
+    // Measure how long the first key after a wake took to decode
+    if (ir_awaiting_decode && ev.type != IR_EVENT_NONE) {
+        ir_awaiting_decode = false;
+        ir_sleep_stats.decode_last_us = ev.time_us - ir_wake_edge_us;
+        if (ir_sleep_stats.decode_last_us > ir_sleep_stats.decode_max_us)
+            ir_sleep_stats.decode_max_us = ir_sleep_stats.decode_last_us;
+    }
+    return ev;
+}
+
+void ir_sleep_init(void) {
+    // Install the wake-up handler on this core, left disabled until ir_sleep()
+    gpio_set_irq_enabled_with_callback(IR_PIN, IR_WAKE_EDGES, false, ir_edge_isr);
+}
+
+bool ir_sleep(void) {
+    // Stay awake while edges are pending, a frame is in progress or a key is held
+    if (ir_read_idx != ir_write_idx() || !ir_decoder_idle(&ir_decoder) || ir_key_state.key >= 0)
+        return false;
+    
+    // No edge seen yet in this sleep
+    uint64_t start_us = time_us_64();
+    ir_wake_edge_seen = false;
+    
+    // Sleep until DMA has captured a pulse. The first word only lands when the pulse that the
+    // falling edge started ends, so the edge interrupt stays armed for every edge until then,
+    // and once an edge has been seen the wait is bounded; nothing relies on the other core's events
+    gpio_set_irq_enabled(IR_PIN, IR_WAKE_EDGES, true);
+    while (ir_read_idx == ir_write_idx()) {
+        if (ir_wake_edge_seen) best_effort_wfe_or_timeout(make_timeout_time_us(IR_WAKE_POLL_US));
+        else __wfe();
+    }
+    gpio_set_irq_enabled(IR_PIN, IR_WAKE_EDGES, false);
+    
+    // Account the time asleep and how quickly the core resumed after the edge that ended the pulse
+    uint32_t now_us = time_us_32();
+    if (!ir_wake_edge_seen) ir_wake_edge_us = ir_last_isr_us = now_us;
+    ir_sleep_stats.sleep_us += time_us_64() - start_us;
+    ir_sleep_stats.sleeps++;
+    if (now_us - ir_last_isr_us > ir_sleep_stats.wake_max_us)
+        ir_sleep_stats.wake_max_us = now_us - ir_last_isr_us;
+    ir_awaiting_decode = true;
+    return true;
+}
+
+void ir_get_sleep_stats(ir_sleep_stats_t *stats) {
+    // Snapshot; fields may be mid-update when read from the other core
+    *stats = ir_sleep_stats;
+}
+
+void ir_get_decode_stats(ir_decode_stats_t *stats) {
+    // Snapshot; fields may be mid-update when read from the other core
+    *stats = ir_decoder.stats;
 }
 
 void process_ir_command(int key, uint16_t *speed) {
     // Process IR remote commands
     switch (key) {
         case 0x18: // Forward command
-            motor_forward(*speed);
-            printf("forward\n");
+            motion_cancel();
+            control_set_target(*speed, *speed);
+            log_event(LOG_FORWARD, 0);
             break;
             
         case 0x08: // Left command
-            motor_left(13107); // ~20% duty for turning
-            printf("left\n");
+            motion_cancel();
+            control_set_target(-13107, 13107); // ~20% duty for turning
+            log_event(LOG_LEFT, 0);
             break;
             
-        case 0x1C: // Stop command
-            motor_stop();
-            printf("stop\n");
+        case 0x1C: // Stop command, brake rather than coast
+            motion_cancel();
+            control_brake(CONTROL_BRAKE_MS);
+            log_event(LOG_STOP, 0);
             break;
             
         case 0x5A: // Right command
-            motor_right(13107); // ~20% duty for turning
-            printf("right\n");
+            motion_cancel();
+            control_set_target(13107, -13107); // ~20% duty for turning
+            log_event(LOG_RIGHT, 0);
             break;
             
         case 0x52: // Backward command
-            motor_backward(*speed);
-            printf("backward\n");
+            motion_cancel();
+            control_set_target(-*speed, -*speed);
+            log_event(LOG_BACKWARD, 0);
             break;
             
         case 0x09: // Reset speed to default
             *speed = 32768;
-            printf("speed: %d\n", *speed);
+            log_event(LOG_SPEED, *speed);
             break;
             
         case 0x15: // Increase speed by ~10%
             if (*speed + 6553 < 65536) *speed += 6553;
-            printf("speed: %d\n", *speed);
+            log_event(LOG_SPEED, *speed);
             break;
             
         case 0x07: // Decrease speed by ~10%
             if (*speed > 6553) *speed -= 6553;
-            printf("speed: %d\n", *speed);
+            log_event(LOG_SPEED, *speed);
+            break;
+            
+        case 0x0C: // Key 1, macro: turn 90 degrees left
+            motion_run_macro(MOTION_MACRO_LEFT_90);
+            log_event(LOG_MACRO, MOTION_MACRO_LEFT_90);
+            break;
+            
+        case 0x5E: // Key 3, macro: turn 90 degrees right
+            motion_run_macro(MOTION_MACRO_RIGHT_90);
+            log_event(LOG_MACRO, MOTION_MACRO_RIGHT_90);
+            break;
+            
+        case 0x42: // Key 7, macro: drive one leg straight ahead
+            motion_run_macro(MOTION_MACRO_LEG);
+            log_event(LOG_MACRO, MOTION_MACRO_LEG);
+            break;
+            
+        case 0x4A: // Key 9, macro: drive a square
+            motion_run_macro(MOTION_MACRO_SQUARE);
+            log_event(LOG_MACRO, MOTION_MACRO_SQUARE);
             break;
             
         default: // Unknown command
-            printf("unknown key: 0x%02X\n", key);
+            log_event(LOG_UNKNOWN_KEY, (uint32_t)key);
+    }
+}
+
+void process_ir_event(ir_event_t ev, uint16_t *speed) {
+    switch (ev.type) {
+        case IR_EVENT_PRESS: // New key, run its command
+            process_ir_command(ev.key, speed);
+            break;
+            
+        case IR_EVENT_HOLD: // Key still held, keep the current motion alive
+            control_feed();
+            break;
+            
+        case IR_EVENT_RELEASE: // No key held any more, stop moving unless a macro runs on its own or a stop is braking
+            if (!motion_busy() && !control_braking()) control_set_target(0, 0);
+            log_event(LOG_RELEASE, 0);
+            break;
+            
+        default: // Nothing changed
+            break;
     }
 }
@@ -36,27 +36,278 @@
 // IR Receiver Pin
 #define IR_PIN 5
 
+// Bit 31 of a captured edge word marks a high (space) pulse
+#define IR_EDGE_HIGH 0x80000000u
+
+// A space at least this long ends any frame; ir_poll() feeds one after this much silence
+#define IR_GAP_US 6000
+
+// Pulses shorter than this are interference and are merged into their neighbours
+#ifndef IR_GLITCH_US
+#define IR_GLITCH_US 150
+#endif
+
+// Key is released when no frame or repeat arrives for this long; repeats come every ~108ms,
+// so one lost repeat (a ~216ms gap) does not release the key
+#define IR_RELEASE_US 250000
+
+/**
+ * @brief IR remote protocols understood by the decoder.
+ */
+typedef enum {
+    IR_PROTOCOL_NONE,     // No protocol (as a filter: accept any)
+    IR_PROTOCOL_NEC,      // NEC, 8-bit address sent with its complement
+    IR_PROTOCOL_NEC_EXT,  // Extended NEC, 16-bit address
+    IR_PROTOCOL_RC5,      // Philips RC5, 5-bit address, 6-bit command (7 with RC5X)
+    IR_PROTOCOL_SIRC,     // Sony SIRC, 7-bit command, 5/8/13-bit address
+    IR_PROTOCOL_COUNT     // Number of protocol identifiers
+} ir_protocol_t;
+
+// Accept frames for this robot only; IR_PROTOCOL_NONE accepts every remote
+#ifndef IR_FILTER_PROTOCOL
+#define IR_FILTER_PROTOCOL IR_PROTOCOL_NONE
+#endif
+
+// Address to accept with IR_FILTER_PROTOCOL, or -1 for any address
+#ifndef IR_FILTER_ADDRESS
+#define IR_FILTER_ADDRESS -1
+#endif
+
+/**
+ * @brief A decoded IR frame.
+ */
+typedef struct {
+    ir_protocol_t protocol;  // Protocol the frame was sent with
+    uint16_t address;        // Device address
+    uint8_t command;         // Command (key) code
+    bool repeat;             // true for a repeat of the previous frame (key held)
+} ir_frame_t;
+
 /**
- * @brief Wait for a GPIO pin to reach a specified logic level or timeout.
+ * @brief Key event types reported by ir_track_key().
+ */
+typedef enum {
+    IR_EVENT_NONE,     // Nothing changed
+    IR_EVENT_PRESS,    // A new key was pressed
+    IR_EVENT_HOLD,     // The pressed key is still held
+    IR_EVENT_RELEASE   // The pressed key was released
+} ir_event_type_t;
+
+/**
+ * @brief A timestamped key event with the command byte it refers to.
+ */
+typedef struct {
+    ir_event_type_t type;  // What happened to the key
+    uint8_t key;           // Command byte of the key
+    uint32_t time_us;      // Time the event was detected, in microseconds
+} ir_event_t;
+
+/**
+ * @brief Press/hold/release tracking state for a single remote key.
+ */
+typedef struct {
+    int key;           // Command byte currently held, or -1 if none
+    uint32_t last_us;  // Time of the last frame or repeat for that key
+} ir_key_state_t;
+
+/**
+ * @brief Position of one protocol's state machine inside a frame.
+ */
+typedef struct {
+    uint8_t state;    // Current position in the frame
+    uint8_t bits;     // Number of data bits received so far
+    uint16_t mark;    // Width of the last bit mark (pulse-coded protocols)
+    uint16_t scale;   // Remote's clock relative to nominal, 256 = 1.0, recovered from the leader
+    uint32_t data;    // Data bits received so far
+} ir_proto_state_t;
+
+/**
+ * @brief Reasons a frame in progress is thrown away.
+ */
+typedef enum {
+    IR_REJECT_TIMING,    // A pulse fell outside every window
+    IR_REJECT_LENGTH,    // Frame ended with a bit count the protocol does not use
+    IR_REJECT_CHECKSUM,  // NEC command and inverted command disagree
+    IR_REJECT_ADDRESS,   // Frame for another protocol or address (IR_FILTER_*)
+    IR_REJECT_REPEAT,    // NEC repeat code with no frame to repeat
+    IR_REJECT_COUNT      // Number of reasons
+} ir_reject_t;
+
+/**
+ * @brief Decoder statistics, counted since ir_decoder_reset().
+ */
+typedef struct {
+    uint32_t frames;                     // Valid frames and repeats decoded
+    uint32_t glitches;                   // Pulses shorter than IR_GLITCH_US merged away
+    uint32_t rejects[IR_REJECT_COUNT];   // Frames thrown away, by reason
+} ir_decode_stats_t;
+
+/**
+ * @brief Incremental multi-protocol decoder state.
+ *
+ * Holds one state machine per protocol so that every protocol sees every edge
+ * in a single pass, and frames can be decoded one pulse at a time across any
+ * number of ir_poll() calls.
+ */
+typedef struct {
+    ir_proto_state_t nec;      // NEC and extended NEC
+    ir_proto_state_t sirc;     // Sony SIRC
+    ir_proto_state_t rc5;      // Philips RC5
+    ir_frame_t last_nec;       // Last NEC frame, repeated by NEC repeat codes
+    int8_t last_rc5_toggle;    // Toggle bit of the last RC5 frame, -1 if none
+    uint8_t last_rc5_command;  // Command of the last RC5 frame
+    ir_protocol_t filter_protocol;  // Only accept this protocol (IR_PROTOCOL_NONE = any)
+    int32_t filter_address;         // Only accept this address (-1 = any)
+    uint32_t held_us;          // Pulse held back by the glitch filter, 0 if none
+    bool held_high;            // Level of the held pulse
+    bool held_merge;           // A glitch split the held pulse, absorb the next one of its level
+    ir_decode_stats_t stats;   // Frames decoded and rejected
+} ir_decoder_t;
+
+/**
+ * @brief Low-power idle statistics kept by ir_sleep().
+ */
+typedef struct {
+    uint64_t sleep_us;        // Total time spent asleep waiting for an IR edge
+    uint32_t sleeps;          // Number of times the core went to sleep
+    uint32_t wake_max_us;     // Worst delay from the edge ending the first captured pulse to the core running
+    uint32_t decode_last_us;  // Waking edge to the first key event, last wake
+    uint32_t decode_max_us;   // Waking edge to the first key event, worst case
+} ir_sleep_stats_t;
+
+/**
+ * @brief Start capturing IR receiver edges in the background.
  *
- * Blocks until the given GPIO pin reads the desired logic level or the timeout (in microseconds) expires.
+ * Configures IR_PIN as an input with pull-up, loads the ir_capture PIO program
+ * that measures every pulse width in microseconds and starts a DMA channel
+ * that copies the measurements into a RAM ring buffer without CPU involvement.
+ */
+void ir_init(void);
+
+/**
+ * @brief Decode any pending IR edges (non-blocking).
  *
- * @param gpio      The GPIO pin number to monitor.
- * @param level     The logic level to wait for (0 or 1).
- * @param timeout_us Timeout in microseconds.
- * @return int64_t  Elapsed time in microseconds, or -1 if timeout occurred.
+ * Consumes the pulse widths captured since the previous call and feeds them
+ * to the decoder. Returns as soon as a frame completes, leaving any later
+ * edges in the ring buffer for the next call. A frame still in progress after
+ * IR_GAP_US of silence is ended with a synthetic long space, since protocols
+ * without a trailing mark only finish on the space that follows them.
+ *
+ * @param frame  Receives the decoded frame.
+ * @return bool  true if a frame was decoded, false if none is complete yet.
  */
-int64_t wait_for_level(unsigned int gpio, bool level, uint32_t timeout_us);
+bool ir_poll(ir_frame_t *frame);
 
 /**
- * @brief Decode a single NEC IR command from the IR receiver (blocking).
+ * @brief Poll the IR receiver for a key event (non-blocking).
  *
- * Waits for a valid NEC IR command and decodes the 32-bit frame.
- * Returns the command byte (data2) if successful, or -1 on failure.
+ * Combines ir_poll() with ir_track_key() using the current time.
  *
- * @return int  The decoded command byte, or -1 if decoding failed.
+ * @return ir_event_t  The next key event, or IR_EVENT_NONE if nothing changed.
  */
-int ir_getkey(void);
+ir_event_t ir_get_event(void);
+
+/**
+ * @brief Turn decoded frames into press/hold/release key events.
+ *
+ * A full frame for a new key reports a press. A repeat frame, or a full frame
+ * for the key already held, reports a hold. When neither arrives for
+ * IR_RELEASE_US the held key is reported as released; a repeat arriving after
+ * that reports a press of the command it repeats, so a key still held through
+ * a burst of lost repeats resumes.
+ *
+ * @param ks      The key tracking state to advance.
+ * @param frame   The frame decoded by ir_poll(), or NULL if there was none.
+ * @param now_us  The current time in microseconds.
+ * @return ir_event_t  The resulting key event.
+ */
+ir_event_t ir_track_key(ir_key_state_t *ks, const ir_frame_t *frame, uint32_t now_us);
+
+/**
+ * @brief Prepare the IR_PIN wake-up interrupt used by ir_sleep().
+ *
+ * Must run on the core that calls ir_sleep(), since the interrupt is enabled
+ * on the calling core only.
+ */
+void ir_sleep_init(void);
+
+/**
+ * @brief Sleep until the next IR edge when there is nothing to decode.
+ *
+ * Puts the calling core into WFE, woken by edges on IR_PIN until DMA has
+ * captured the first pulse of a frame. Edges keep being captured by PIO and
+ * DMA while the core sleeps, so the first frame after waking decodes normally. Returns at once without sleeping while
+ * a frame is being decoded or a key is held, because the release timeout
+ * still has to be polled.
+ *
+ * @return bool  true if the core slept, false if it had to stay awake.
+ */
+bool ir_sleep(void);
+
+/**
+ * @brief Copy the low-power idle statistics.
+ *
+ * @param stats  Receives the statistics.
+ */
+void ir_get_sleep_stats(ir_sleep_stats_t *stats);
+
+/**
+ * @brief Copy the decoder statistics.
+ *
+ * @param stats  Receives the statistics.
+ */
+void ir_get_decode_stats(ir_decode_stats_t *stats);
+
+/**
+ * @brief Reset a decoder to wait for the start of the next frame.
+ *
+ * Clears the frame in progress, the repeat history and the statistics, and
+ * sets the address filter to IR_FILTER_PROTOCOL/IR_FILTER_ADDRESS.
+ *
+ * @param dec  The decoder to reset.
+ */
+void ir_decoder_reset(ir_decoder_t *dec);
+
+/**
+ * @brief Restrict a decoder to frames meant for this robot.
+ *
+ * Frames from other protocols or addresses are dropped, as early in the frame
+ * as the protocol allows (after the address bits for NEC and RC5).
+ *
+ * @param dec       The decoder to configure.
+ * @param protocol  The protocol to accept, or IR_PROTOCOL_NONE for any.
+ * @param address   The address to accept, or -1 for any.
+ */
+void ir_decoder_set_filter(ir_decoder_t *dec, ir_protocol_t protocol, int32_t address);
+
+/**
+ * @brief Check whether a decoder is between frames.
+ *
+ * @param dec  The decoder to check.
+ * @return bool  true if no frame is partly decoded.
+ */
+bool ir_decoder_idle(const ir_decoder_t *dec);
+
+/**
+ * @brief Feed one captured pulse width to every protocol decoder.
+ *
+ * A low pulse is passed as its width in microseconds. A high pulse is passed
+ * as the bitwise inverse of its width, so bit 31 (IR_EDGE_HIGH) is set. This
+ * is the exact word format produced by the ir_capture PIO program, which lets
+ * recorded traces be replayed through the decoder off target. Each protocol
+ * does a constant amount of work per edge, driven by its timing table scaled
+ * to the clock recovered from the frame's leader.
+ *
+ * Pulses are delayed by one edge so that a glitch shorter than IR_GLITCH_US,
+ * together with the pulse after it, can be merged back into the pulse it
+ * split. Pulses of IR_GAP_US or more are never delayed.
+ *
+ * @param dec    The decoder state to advance.
+ * @param edge   The captured pulse width word.
+ * @param frame  Receives the frame when this edge completes one.
+ * @return bool  true if a valid frame for this robot was completed.
+ */
+bool ir_decode_edge(ir_decoder_t *dec, uint32_t edge, ir_frame_t *frame);
 
 /**
  * @brief Process IR remote command and control robot accordingly.
@@ -69,4 +320,17 @@ int ir_getkey(void);
  */
 void process_ir_command(int key, uint16_t *speed);
 
+/**
+ * @brief Apply a key event to the robot.
+ *
+ * A press runs process_ir_command(). A hold feeds the control failsafe so the
+ * current motion keeps going. Releasing the key ramps the motors to a stop,
+ * unless a motion macro started by the key is still running or the stop key's
+ * brake has not run out yet.
+ *
+ * @param ev     The key event to process.
+ * @param speed  Pointer to the current speed value (modified by speed commands).
+ */
+void process_ir_event(ir_event_t ev, uint16_t *speed);
+
 #endif // IR_H
@@ -0,0 +1,647 @@
+/**
+ * @file ir_decode.c
+ * @brief Hardware-independent multi-protocol IR decoder (NEC, RC5, SIRC) and key tracking
+ * @author Kevin Thomas
+ * @date 2025
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Kevin Thomas
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "ir.h"
+#include "ramfunc.h"
+#include <stddef.h>
+
+// Protocol state machine states
+enum {
+    IR_STATE_IDLE,    // Waiting for the start of a frame
+    IR_STATE_LEADER,  // Waiting for the leader (or repeat) space
+    IR_STATE_MARK,    // Waiting for a bit mark (RC5: inside a frame)
+    IR_STATE_SPACE,   // Waiting for a bit space
+    IR_STATE_REPEAT   // Waiting for the mark ending a repeat frame
+};
+
+// Result of feeding one edge to a protocol state machine
+enum {
+    IR_STEP_BUSY,     // Nothing to report
+    IR_STEP_BIT,      // A data bit was added
+    IR_STEP_FRAME,    // A frame completed, data and bits are valid
+    IR_STEP_REPEAT,   // A repeat frame completed
+    IR_STEP_TIMING,   // A frame was dropped, a pulse was out of window
+    IR_STEP_LENGTH    // A frame was dropped, it ended with too few bits
+};
+
+// Frames dropped with fewer bits are false starts on another protocol, not counted
+#define IR_REJECT_MIN_BITS 4
+
+// Clock scale of a remote running at nominal speed
+#define IR_SCALE_ONE 256
+
+// RC5 half-bit level waiting for the second half of its bit
+enum {
+    IR_HALF_NONE,     // Bit boundary
+    IR_HALF_SPACE,    // First half was a space
+    IR_HALF_MARK      // First half was a mark
+};
+
+/**
+ * @brief Timing table of a pulse-coded protocol, times in microseconds.
+ */
+typedef struct {
+    uint16_t leader_mark;    // Leader low pulse
+    uint16_t leader_space;   // Leader high pulse
+    uint16_t repeat_space;   // Leader high pulse of a repeat frame, 0 if none
+    uint16_t zero_mark;      // '0' bit low pulse
+    uint16_t zero_space;     // '0' bit high pulse
+    uint16_t one_mark;       // '1' bit low pulse
+    uint16_t one_space;      // '1' bit high pulse
+    uint8_t min_bits;        // Fewest bits in a frame
+    uint8_t max_bits;        // Most bits in a frame; reaching it ends the frame
+    uint8_t filter_bits;     // Bits after which the address is known, 0 if only at the end
+    uint8_t tolerance_pct;   // Allowed deviation from every nominal time
+} ir_pulse_timing_t;
+
+/**
+ * @brief Timing table of a Manchester-coded protocol, times in microseconds.
+ */
+typedef struct {
+    uint16_t half_bit;       // Duration of half a bit
+    uint8_t bits;            // Bits in a frame, start bits included
+    uint8_t filter_bits;     // Bits after which the address is known
+    uint8_t tolerance_pct;   // Allowed deviation from every nominal time
+} ir_manchester_timing_t;
+
+// NEC: 9ms + 4.5ms leader (2.25ms space for repeats), pulse-distance bits, 32 bits LSB first
+static const ir_pulse_timing_t ir_nec_timing = {
+    9000, 4500, 2250, 560, 560, 560, 1690, 32, 32, 16, 30
+};
+
+// Sony SIRC: 2.4ms + 0.6ms leader, pulse-width bits, 12/15/20 bits LSB first
+static const ir_pulse_timing_t ir_sirc_timing = {
+    2400, 600, 0, 600, 600, 1200, 600, 12, 20, 0, 30
+};
+
+// Philips RC5: 889us half bits, 14 bits MSB first (2 start, toggle, 5 address, 6 command)
+static const ir_manchester_timing_t ir_rc5_timing = {
+    889, 14, 8, 25
+};
+
+/**
+ * @brief Check a pulse width against a nominal time.
+ *
+ * @param t        The measured width.
+ * @param nominal  The expected width.
+ * @param pct      The allowed deviation in percent.
+ * @return bool    true if t is within pct of nominal.
+ */
+static inline bool ir_match(uint32_t t, uint32_t nominal, uint32_t pct) {
+    uint32_t diff = t > nominal ? t - nominal : nominal - t;
+    return diff <= nominal * pct / 100;
+}
+
+/**
+ * @brief Return a protocol state machine to idle.
+ *
+ * @param st  The state machine to reset.
+ */
+static inline void ir_proto_reset(ir_proto_state_t *st) {
+    st->state = IR_STATE_IDLE;
+    st->bits = 0;
+    st->mark = 0;
+    st->scale = IR_SCALE_ONE;
+    st->data = 0;
+}
+
+/**
+ * @brief Scale a nominal time to the clock recovered for the current frame.
+ *
+ * @param st       The state machine holding the recovered clock.
+ * @param nominal  The nominal time from the timing table.
+ * @return uint32_t  The time this remote actually uses.
+ */
+static inline uint32_t ir_scaled(const ir_proto_state_t *st, uint32_t nominal) {
+    return nominal * st->scale / IR_SCALE_ONE;
+}
+
+/**
+ * @brief Classify a dropped frame for the statistics.
+ *
+ * @param st      The state machine that dropped it.
+ * @param reason  IR_STEP_TIMING or IR_STEP_LENGTH.
+ * @return int    reason, or IR_STEP_BUSY for a false start.
+ */
+static inline int ir_proto_reject(const ir_proto_state_t *st, int reason) {
+    return st->bits >= IR_REJECT_MIN_BITS ? reason : IR_STEP_BUSY;
+}
+
+/**
+ * @brief Advance a pulse-coded (NEC, SIRC) state machine by one edge.
+ *
+ * Bits are stored LSB first. A space far longer than any bit space ends a
+ * pulse-width coded frame early, the last bit being read from its mark alone.
+ * The leader mark sets the clock every later window is scaled to, so a remote
+ * running fast or slow keeps its pulses centred in the windows.
+ *
+ * @param st    The state machine.
+ * @param tm    The protocol timing table.
+ * @param high  true for a space, false for a mark.
+ * @param t     The pulse width in microseconds.
+ * @return int  One of IR_STEP_*.
+ */
+static int RAM_FUNC(ir_pulse_step)(ir_proto_state_t *st, const ir_pulse_timing_t *tm, bool high, uint32_t t) {
+    uint32_t tol = tm->tolerance_pct;
+    int reason = IR_STEP_TIMING;
+    
+    switch (st->state) {
+        case IR_STATE_LEADER: // Leader space, or the shorter space of a repeat frame
+            if (high && ir_match(t, ir_scaled(st, tm->leader_space), tol)) {
+                st->state = IR_STATE_MARK;
+                return IR_STEP_BUSY;
+            }
+            if (high && tm->repeat_space && ir_match(t, ir_scaled(st, tm->repeat_space), tol)) {
+                st->state = IR_STATE_REPEAT;
+                return IR_STEP_BUSY;
+            }
+            break;
+            
+        case IR_STATE_REPEAT: // Repeat frame ends with a single bit mark
+            if (!high && ir_match(t, ir_scaled(st, tm->zero_mark), tol)) {
+                ir_proto_reset(st);
+                return IR_STEP_REPEAT;
+            }
+            break;
+            
+        case IR_STATE_MARK: // Bit mark of either width
+            if (!high && (ir_match(t, ir_scaled(st, tm->zero_mark), tol) ||
+                          ir_match(t, ir_scaled(st, tm->one_mark), tol))) {
+                st->mark = (uint16_t)t;
+                st->state = IR_STATE_SPACE;
+                return IR_STEP_BUSY;
+            }
+            break;
+            
+        case IR_STATE_SPACE: { // Bit space; the mark/space pair gives the bit value
+            if (!high) break;
+            
+            bool one_mark = ir_match(st->mark, ir_scaled(st, tm->one_mark), tol);
+            bool zero_mark = ir_match(st->mark, ir_scaled(st, tm->zero_mark), tol);
+            uint32_t longest = ir_scaled(st, tm->one_space > tm->zero_space ? tm->one_space : tm->zero_space);
+            bool last = false;
+            uint32_t bit;
+            
+            if (one_mark && ir_match(t, ir_scaled(st, tm->one_space), tol)) {
+                bit = 1;
+            } else if (zero_mark && ir_match(t, ir_scaled(st, tm->zero_space), tol)) {
+                bit = 0;
+            } else if (tm->one_mark != tm->zero_mark && t > longest * (100 + tol) / 100) {
+                // Gap after the final bit of a pulse-width coded frame
+                bit = one_mark;
+                last = true;
+            } else {
+                break;
+            }
+            
+            st->data |= bit << st->bits;
+            st->bits++;
+            
+            // Frame ends at the maximum length or at a gap
+            if (last || st->bits == tm->max_bits) {
+                st->state = IR_STATE_IDLE;
+                if (st->bits >= tm->min_bits) return IR_STEP_FRAME;
+                reason = IR_STEP_LENGTH;
+                break;
+            }
+            
+            st->state = IR_STATE_MARK;
+            return IR_STEP_BIT;
+        }
+            
+        default: // Idle, handled below
+            break;
+    }
+    
+    // Out of sequence or out of window, start over; the pulse may itself be a new leader
+    int result = ir_proto_reject(st, reason);
+    ir_proto_reset(st);
+    if (!high && ir_match(t, tm->leader_mark, tol)) {
+        // Recover the remote's clock from its leader
+        st->state = IR_STATE_LEADER;
+        st->scale = (uint16_t)(t * IR_SCALE_ONE / tm->leader_mark);
+    }
+    return result;
+}
+
+/**
+ * @brief Advance a Manchester-coded (RC5) state machine by one edge.
+ *
+ * Each pulse is split into one or two half bits. A space then a mark is a '1',
+ * a mark then a space is a '0'. Bits are stored MSB first. The frame starts
+ * with a '1' whose space half is indistinguishable from idle, so decoding
+ * begins on the first mark. A final '0' ends in a space that merges into
+ * idle, so any long space counts as one half bit; if that does not complete
+ * the frame, the frame is over and dropped. There is no leader to recover the
+ * clock from, so the nominal half bit is used throughout.
+ *
+ * @param st    The state machine.
+ * @param tm    The protocol timing table.
+ * @param high  true for a space, false for a mark.
+ * @param t     The pulse width in microseconds.
+ * @return int  One of IR_STEP_*.
+ */
+static int RAM_FUNC(ir_manchester_step)(ir_proto_state_t *st, const ir_manchester_timing_t *tm, bool high, uint32_t t) {
+    uint32_t tol = tm->tolerance_pct;
+    uint32_t half = tm->half_bit;
+    int halves = 0;
+    bool long_space = false;
+    
+    // Number of half bits this pulse spans
+    if (ir_match(t, half, tol)) {
+        halves = 1;
+    } else if (ir_match(t, 2u * half, tol)) {
+        halves = 2;
+    } else if (high && st->state != IR_STATE_IDLE && t > 2u * half * (100 + tol) / 100) {
+        halves = 1;
+        long_space = true;
+    }
+    
+    if (st->state == IR_STATE_IDLE) {
+        // A frame opens with the mark half of its first start bit (two halves for RC5X)
+        if (high || halves == 0) return IR_STEP_BUSY;
+        ir_proto_reset(st);
+        st->state = IR_STATE_MARK;
+        st->mark = IR_HALF_SPACE;
+    } else if (halves == 0) {
+        int result = ir_proto_reject(st, IR_STEP_TIMING);
+        ir_proto_reset(st);
+        return result;
+    }
+    
+    int result = IR_STEP_BUSY;
+    uint16_t level = high ? IR_HALF_SPACE : IR_HALF_MARK;
+    
+    for (int i = 0; i < halves; i++) {
+        // First half of a bit, wait for the second
+        if (st->mark == IR_HALF_NONE) {
+            st->mark = level;
+            continue;
+        }
+        
+        // Both halves equal is not valid Manchester
+        if (st->mark == level) {
+            int result = ir_proto_reject(st, IR_STEP_TIMING);
+            ir_proto_reset(st);
+            return result;
+        }
+        
+        // Space then mark is a '1'
+        st->data = (st->data << 1) | (st->mark == IR_HALF_SPACE);
+        st->bits++;
+        st->mark = IR_HALF_NONE;
+        
+        if (st->bits == tm->bits) {
+            st->state = IR_STATE_IDLE;
+            return IR_STEP_FRAME;
+        }
+        result = IR_STEP_BIT;
+    }
+    
+    // Silence with bits still missing, e.g. the rest of a frame dropped by the address filter
+    if (long_space) {
+        result = ir_proto_reject(st, IR_STEP_LENGTH);
+        ir_proto_reset(st);
+    }
+    return result;
+}
+
+/**
+ * @brief Check whether the address filter lets a protocol through at all.
+ *
+ * @param dec       The decoder.
+ * @param protocol  The protocol to check.
+ * @return bool     true if frames of this protocol may be accepted.
+ */
+static inline bool ir_filter_protocol(const ir_decoder_t *dec, ir_protocol_t protocol) {
+    return dec->filter_protocol == IR_PROTOCOL_NONE || dec->filter_protocol == protocol;
+}
+
+/**
+ * @brief Check a frame's protocol and address against the filter.
+ *
+ * @param dec    The decoder.
+ * @param frame  The (possibly partial) frame to check.
+ * @return bool  true if the frame is meant for this robot.
+ */
+static inline bool ir_filter_pass(const ir_decoder_t *dec, const ir_frame_t *frame) {
+    if (dec->filter_protocol == IR_PROTOCOL_NONE) return true;
+    return frame->protocol == dec->filter_protocol &&
+           (dec->filter_address < 0 || dec->filter_address == frame->address);
+}
+
+/**
+ * @brief Count a dropped frame.
+ *
+ * @param dec     The decoder.
+ * @param reason  Why the frame was dropped.
+ * @return bool   Always false, for returning straight from a protocol step.
+ */
+static inline bool ir_reject(ir_decoder_t *dec, ir_reject_t reason) {
+    dec->stats.rejects[reason]++;
+    return false;
+}
+
+/**
+ * @brief Count a frame a state machine dropped on its own.
+ *
+ * @param dec   The decoder.
+ * @param step  The state machine's IR_STEP_* result.
+ * @return int  step, unchanged.
+ */
+static inline int ir_step_stats(ir_decoder_t *dec, int step) {
+    if (step == IR_STEP_TIMING) ir_reject(dec, IR_REJECT_TIMING);
+    else if (step == IR_STEP_LENGTH) ir_reject(dec, IR_REJECT_LENGTH);
+    return step;
+}
+
+/**
+ * @brief Fill in the protocol and address of an NEC frame from its first 16 bits.
+ *
+ * @param data   The received bits, LSB first.
+ * @param frame  Receives protocol and address.
+ */
+static inline void ir_nec_address(uint32_t data, ir_frame_t *frame) {
+    // Standard NEC sends the address with its complement, extended NEC a 16-bit address
+    uint8_t lo = (uint8_t)data, hi = (uint8_t)(data >> 8);
+    if ((uint8_t)(lo + hi) == 0xFF) {
+        frame->protocol = IR_PROTOCOL_NEC;
+        frame->address = lo;
+    } else {
+        frame->protocol = IR_PROTOCOL_NEC_EXT;
+        frame->address = (uint16_t)data;
+    }
+}
+
+/**
+ * @brief Feed an edge to the NEC decoder.
+ *
+ * @param dec    The decoder.
+ * @param high   true for a space, false for a mark.
+ * @param t      The pulse width in microseconds.
+ * @param frame  Receives the frame when one completes.
+ * @return bool  true if a frame for this robot completed.
+ */
+static bool RAM_FUNC(ir_nec_step)(ir_decoder_t *dec, bool high, uint32_t t, ir_frame_t *frame) {
+    ir_proto_state_t *st = &dec->nec;
+    
+    switch (ir_step_stats(dec, ir_pulse_step(st, &ir_nec_timing, high, t))) {
+        case IR_STEP_BIT: // Address is known after 16 bits, drop frames for other robots now
+            if (st->bits == ir_nec_timing.filter_bits) {
+                ir_nec_address(st->data, frame);
+                if (!ir_filter_pass(dec, frame)) {
+                    ir_proto_reset(st);
+                    ir_reject(dec, IR_REJECT_ADDRESS);
+                }
+            }
+            return false;
+            
+        case IR_STEP_REPEAT: // Repeat of the last NEC frame, if there was one
+            if (dec->last_nec.protocol == IR_PROTOCOL_NONE) return ir_reject(dec, IR_REJECT_REPEAT);
+            *frame = dec->last_nec;
+            frame->repeat = true;
+            return true;
+            
+        case IR_STEP_FRAME: { // Verify the command checksum (command + ~command = 0xFF)
+            uint8_t cmd = (uint8_t)(st->data >> 16);
+            if ((uint8_t)(cmd + (uint8_t)(st->data >> 24)) != 0xFF) return ir_reject(dec, IR_REJECT_CHECKSUM);
+            
+            ir_nec_address(st->data, frame);
+            frame->command = cmd;
+            frame->repeat = false;
+            if (!ir_filter_pass(dec, frame)) return ir_reject(dec, IR_REJECT_ADDRESS);
+            
+            dec->last_nec = *frame;
+            return true;
+        }
+            
+        default:
+            return false;
+    }
+}
+
+/**
+ * @brief Feed an edge to the Sony SIRC decoder.
+ *
+ * @param dec    The decoder.
+ * @param high   true for a space, false for a mark.
+ * @param t      The pulse width in microseconds.
+ * @param frame  Receives the frame when one completes.
+ * @return bool  true if a frame for this robot completed.
+ */
+static bool RAM_FUNC(ir_sirc_step)(ir_decoder_t *dec, bool high, uint32_t t, ir_frame_t *frame) {
+    ir_proto_state_t *st = &dec->sirc;
+    
+    if (ir_step_stats(dec, ir_pulse_step(st, &ir_sirc_timing, high, t)) != IR_STEP_FRAME) return false;
+    
+    // Only the 12, 15 and 20 bit variants exist
+    if (st->bits != 12 && st->bits != 15 && st->bits != 20) return ir_reject(dec, IR_REJECT_LENGTH);
+    
+    // 7 command bits, then the address
+    frame->protocol = IR_PROTOCOL_SIRC;
+    frame->command = (uint8_t)(st->data & 0x7F);
+    frame->address = (uint16_t)(st->data >> 7);
+    frame->repeat = false;
+    return ir_filter_pass(dec, frame) || ir_reject(dec, IR_REJECT_ADDRESS);
+}
+
+/**
+ * @brief Feed an edge to the Philips RC5 decoder.
+ *
+ * @param dec    The decoder.
+ * @param high   true for a space, false for a mark.
+ * @param t      The pulse width in microseconds.
+ * @param frame  Receives the frame when one completes.
+ * @return bool  true if a frame for this robot completed.
+ */
+static bool RAM_FUNC(ir_rc5_step)(ir_decoder_t *dec, bool high, uint32_t t, ir_frame_t *frame) {
+    ir_proto_state_t *st = &dec->rc5;
+    
+    switch (ir_step_stats(dec, ir_manchester_step(st, &ir_rc5_timing, high, t))) {
+        case IR_STEP_BIT: // Start bits, toggle and address are in after 8 bits
+            if (st->bits == ir_rc5_timing.filter_bits) {
+                frame->protocol = IR_PROTOCOL_RC5;
+                frame->address = (uint16_t)(st->data & 0x1F);
+                if (!ir_filter_pass(dec, frame)) {
+                    ir_proto_reset(st);
+                    ir_reject(dec, IR_REJECT_ADDRESS);
+                }
+            }
+            return false;
+            
+        case IR_STEP_FRAME: { // S1 S2 T A4..A0 C5..C0; an inverted S2 is command bit 6 (RC5X)
+            int8_t toggle = (int8_t)((st->data >> 11) & 1);
+            frame->protocol = IR_PROTOCOL_RC5;
+            frame->address = (uint16_t)((st->data >> 6) & 0x1F);
+            frame->command = (uint8_t)((st->data & 0x3F) | ((~st->data >> 12) & 1) << 6);
+            if (!ir_filter_pass(dec, frame)) return ir_reject(dec, IR_REJECT_ADDRESS);
+            
+            // The toggle bit only flips on a new key press
+            frame->repeat = toggle == dec->last_rc5_toggle && frame->command == dec->last_rc5_command;
+            dec->last_rc5_toggle = toggle;
+            dec->last_rc5_command = frame->command;
+            return true;
+        }
+            
+        default:
+            return false;
+    }
+}
+
+void ir_decoder_reset(ir_decoder_t *dec) {
+    // Every protocol waits for a new frame with no history
+    ir_proto_reset(&dec->nec);
+    ir_proto_reset(&dec->sirc);
+    ir_proto_reset(&dec->rc5);
+    dec->last_nec.protocol = IR_PROTOCOL_NONE;
+    dec->last_rc5_toggle = -1;
+    dec->last_rc5_command = 0;
+    dec->held_us = 0;
+    dec->held_high = false;
+    dec->held_merge = false;
+    dec->stats = (ir_decode_stats_t){ 0 };
+    
+    // Build-time address filter
+    ir_decoder_set_filter(dec, IR_FILTER_PROTOCOL, IR_FILTER_ADDRESS);
+}
+
+void ir_decoder_set_filter(ir_decoder_t *dec, ir_protocol_t protocol, int32_t address) {
+    // Accept only this protocol/address from now on
+    dec->filter_protocol = protocol;
+    dec->filter_address = address;
+}
+
+bool ir_decoder_idle(const ir_decoder_t *dec) {
+    // No pulse held back and no protocol has a frame in progress
+    return dec->held_us == 0 && dec->nec.state == IR_STATE_IDLE &&
+           dec->sirc.state == IR_STATE_IDLE && dec->rc5.state == IR_STATE_IDLE;
+}
+
+/**
+ * @brief Feed one filtered pulse to every protocol the filter allows.
+ *
+ * @param dec    The decoder.
+ * @param high   true for a space, false for a mark.
+ * @param t      The pulse width in microseconds.
+ * @param frame  Receives the frame when one completes.
+ * @return bool  true if a valid frame for this robot was completed.
+ */
+static bool RAM_FUNC(ir_decode_pulse)(ir_decoder_t *dec, bool high, uint32_t t, ir_frame_t *frame) {
+    // Run every protocol on the pulse, keeping the first frame completed
+    ir_frame_t f;
+    bool done = false;
+    if ((ir_filter_protocol(dec, IR_PROTOCOL_NEC) || ir_filter_protocol(dec, IR_PROTOCOL_NEC_EXT)) &&
+        ir_nec_step(dec, high, t, &f)) {
+        *frame = f;
+        done = true;
+    }
+    if (ir_filter_protocol(dec, IR_PROTOCOL_SIRC) && ir_sirc_step(dec, high, t, &f) && !done) {
+        *frame = f;
+        done = true;
+    }
+    if (ir_filter_protocol(dec, IR_PROTOCOL_RC5) && ir_rc5_step(dec, high, t, &f) && !done) {
+        *frame = f;
+        done = true;
+    }
+    
+    // A complete frame ends whatever the other protocols thought they were seeing
+    if (done) {
+        dec->stats.frames++;
+        ir_proto_reset(&dec->nec);
+        ir_proto_reset(&dec->sirc);
+        ir_proto_reset(&dec->rc5);
+    }
+    return done;
+}
+
+bool RAM_FUNC(ir_decode_edge)(ir_decoder_t *dec, uint32_t edge, ir_frame_t *frame) {
+    // Split the edge word into level and width in microseconds
+    bool high = (edge & IR_EDGE_HIGH) != 0;
+    uint32_t t = high ? ~edge : edge;
+    
+    // A glitch splits a pulse in three; fold it and the rest of the pulse back in
+    if (t < IR_GLITCH_US) {
+        dec->stats.glitches++;
+        if (dec->held_us) {
+            dec->held_us += t;
+            dec->held_merge = true;
+        }
+        return false;
+    }
+    if (dec->held_merge && high == dec->held_high) {
+        dec->held_merge = false;
+        dec->held_us += t;
+        if (dec->held_us < IR_GAP_US) return false;
+        t = dec->held_us;
+        dec->held_us = 0;
+        return ir_decode_pulse(dec, high, t, frame);
+    }
+    
+    // Release the held pulse now that it is known to be whole, hold this one
+    bool done = false;
+    if (dec->held_us) done = ir_decode_pulse(dec, dec->held_high, dec->held_us, frame);
+    dec->held_merge = false;
+    dec->held_high = high;
+    dec->held_us = t;
+    
+    // Gaps end frames at once rather than waiting for the next frame's first edge
+    if (t >= IR_GAP_US) {
+        dec->held_us = 0;
+        if (!done) done = ir_decode_pulse(dec, high, t, frame);
+    }
+    return done;
+}
+
+ir_event_t RAM_FUNC(ir_track_key)(ir_key_state_t *ks, const ir_frame_t *frame, uint32_t now_us) {
+    ir_event_t ev = { IR_EVENT_NONE, 0, now_us };
+    
+    if (frame && frame->repeat) {
+        // Repeat frame, a press again if the key was already taken as released
+        ev.type = (frame->command == ks->key) ? IR_EVENT_HOLD : IR_EVENT_PRESS;
+        ks->key = frame->command;
+        ks->last_us = now_us;
+    } else if (frame) {
+        // Full frame, a press unless that key is already held
+        ev.type = (frame->command == ks->key) ? IR_EVENT_HOLD : IR_EVENT_PRESS;
+        ks->key = frame->command;
+        ks->last_us = now_us;
+    } else if (ks->key >= 0 && now_us - ks->last_us > IR_RELEASE_US) {
+        // No frame or repeat in time, the key was released
+        ev.type = IR_EVENT_RELEASE;
+        ev.key = (uint8_t)ks->key;
+        ks->key = -1;
+        return ev;
+    } else {
+        // Nothing changed
+        return ev;
+    }
+    
+    ev.key = (uint8_t)ks->key;
+    return ev;
+}
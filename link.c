@@ -0,0 +1,276 @@
+/**
+ * @file link.c
+ * @brief Framed binary control protocol over USB CDC stdio
+ * @author Kevin Thomas
+ * @date 2025
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Kevin Thomas
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "link.h"
+#include "control.h"
+#include "robot.h"
+#include "motion.h"
+#include <string.h>
+#include "pico/stdlib.h"
+
+// Bytes since the last delimiter or line end; a frame is COBS decoded in place once it closes
+static uint8_t link_rx[LINK_RX_MAX];
+static uint32_t link_rx_len;
+
+// Opened by a delimiter (so never text), only printable ASCII so far, and outgrew link_rx
+static bool link_rx_framed;
+static bool link_rx_text = true;
+static bool link_rx_overflow;
+
+_Static_assert(LINK_RX_MAX >= LINK_WIRE_MAX, "a whole frame must fit the receive buffer");
+
+// Frames accepted and dropped, reported in telemetry
+static uint16_t link_frames;
+static uint16_t link_errors;
+
+/**
+ * @brief Read a little-endian 16-bit field.
+ *
+ * @param p          The first byte of the field.
+ * @return uint16_t  The field value.
+ */
+static inline uint16_t link_get_u16(const uint8_t *p) {
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+/**
+ * @brief Write a little-endian 16-bit field.
+ *
+ * @param p  The first byte of the field.
+ * @param v  The value to write.
+ */
+static inline void link_put_u16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+size_t link_cobs_encode(const uint8_t *src, size_t len, uint8_t *dst) {
+    // Each block starts with the distance to the next zero (or block end)
+    size_t code_idx = 0, out = 1;
+    uint8_t code = 1;
+    for (size_t i = 0; i < len; i++) {
+        if (src[i]) {
+            dst[out++] = src[i];
+            code++;
+        }
+        
+        // Close the block at a zero or when it reaches the 254 byte limit
+        if (!src[i] || code == 0xFF) {
+            dst[code_idx] = code;
+            code_idx = out++;
+            code = 1;
+        }
+    }
+    dst[code_idx] = code;
+    return out;
+}
+
+int link_cobs_decode(uint8_t *buf, size_t len) {
+    // Output never overtakes input, so decoding in place is safe
+    size_t in = 0, out = 0;
+    while (in < len) {
+        uint8_t code = buf[in++];
+        if (code == 0 || in + code - 1 > len) return -1;
+        memmove(&buf[out], &buf[in], code - 1u);
+        out += code - 1u;
+        in += code - 1u;
+        
+        // A short block stands for a zero, except at the very end
+        if (code != 0xFF && in < len) buf[out++] = 0;
+    }
+    return (int)out;
+}
+
+uint16_t link_crc16(const uint8_t *data, size_t len) {
+    // Bitwise CRC-16/CCITT-FALSE; frames are short enough not to need a table
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int b = 0; b < 8; b++)
+            crc = (crc & 0x8000) ? (uint16_t)(crc << 1) ^ 0x1021 : (uint16_t)(crc << 1);
+    }
+    return crc;
+}
+
+/**
+ * @brief Build, encode and send a frame.
+ *
+ * @param type  The message type.
+ * @param seq   The sequence number.
+ * @param body  The body bytes.
+ * @param len   Number of body bytes.
+ */
+static void link_send(uint8_t type, uint8_t seq, const uint8_t *body, size_t len) {
+    // Header, body, CRC
+    uint8_t frame[LINK_FRAME_MAX];
+    frame[0] = type;
+    frame[1] = seq;
+    memcpy(&frame[2], body, len);
+    link_put_u16(&frame[2 + len], link_crc16(frame, 2 + len));
+    
+    // Encode between delimiters; putchar_raw skips the CR/LF translation printf does
+    uint8_t wire[LINK_WIRE_MAX];
+    wire[0] = 0;
+    size_t n = link_cobs_encode(frame, len + 4, &wire[1]) + 1;
+    wire[n++] = 0;
+    for (size_t i = 0; i < n; i++)
+        putchar_raw(wire[i]);
+}
+
+/**
+ * @brief Send a LINK_REPLY_TELEMETRY frame.
+ *
+ * @param seq  The sequence number of the request being answered.
+ */
+static void link_send_telemetry(uint8_t seq) {
+    // Applied duty halved to fit 16 bits, like LINK_MSG_DRIVE
+    int32_t left, right;
+    control_get_applied(&left, &right);
+    uint8_t flags = (control_tripped() ? LINK_FLAG_FAILSAFE : 0) | (motion_busy() ? LINK_FLAG_MOTION : 0);
+    
+    // Fields in link_telemetry_t order
+    uint8_t body[13];
+    uint32_t now_us = time_us_32();
+    link_put_u16(&body[0], (uint16_t)now_us);
+    link_put_u16(&body[2], (uint16_t)(now_us >> 16));
+    link_put_u16(&body[4], (uint16_t)(left / 2));
+    link_put_u16(&body[6], (uint16_t)(right / 2));
+    body[8] = flags;
+    link_put_u16(&body[9], link_frames);
+    link_put_u16(&body[11], link_errors);
+    link_send(LINK_REPLY_TELEMETRY, seq, body, sizeof(body));
+}
+
+/**
+ * @brief Act on a decoded, CRC-checked frame.
+ *
+ * @param frame  The frame, still in the receive buffer.
+ * @param len    Frame length without the CRC.
+ * @return bool  true if the frame was understood.
+ */
+static bool link_dispatch(const uint8_t *frame, size_t len) {
+    const uint8_t *body = &frame[2];
+    size_t body_len = len - 2;
+    
+    switch (frame[0]) {
+        case LINK_MSG_DRIVE: // New setpoint, takes over from any motion sequence
+            if (body_len != 4) return false;
+            motion_cancel();
+            control_set_target((int16_t)link_get_u16(&body[0]) * 2, (int16_t)link_get_u16(&body[2]) * 2);
+            return true;
+            
+        case LINK_MSG_ARCADE: { // Throttle and turn, mixed into wheel duties
+            if (body_len != 4) return false;
+            int32_t left, right;
+            motor_mix((int16_t)link_get_u16(&body[0]) * 2, (int16_t)link_get_u16(&body[2]) * 2, &left, &right);
+            motion_cancel();
+            control_set_target(left, right);
+            return true;
+        }
+            
+        case LINK_MSG_HEARTBEAT: // Companion still in control
+            if (body_len != 0) return false;
+            control_feed();
+            return true;
+            
+        case LINK_MSG_BRAKE: // Stop now
+            if (body_len != 2) return false;
+            motion_cancel();
+            control_brake(link_get_u16(&body[0]));
+            return true;
+            
+        case LINK_MSG_TELEMETRY: // Report state
+            if (body_len != 0) return false;
+            link_send_telemetry(frame[1]);
+            return true;
+            
+        default: // Unknown message
+            return false;
+    }
+}
+
+/**
+ * @brief Decode, check and dispatch the frame in link_rx.
+ */
+static void link_frame_end(void) {
+    // Decode in place; header and CRC make 4 bytes at least
+    int len = link_rx_overflow ? -1 : link_cobs_decode(link_rx, link_rx_len);
+    bool ok = len >= 4 &&
+              link_get_u16(&link_rx[len - 2]) == link_crc16(link_rx, (size_t)len - 2) &&
+              link_dispatch(link_rx, (size_t)len - 2);
+    if (ok) link_frames++;
+    else link_errors++;
+}
+
+/**
+ * @brief Empty link_rx for whatever follows.
+ *
+ * @param framed  true if a delimiter opened it, so it can only be a frame.
+ */
+static void link_rx_restart(bool framed) {
+    link_rx_len = 0;
+    link_rx_framed = framed;
+    link_rx_text = true;
+    link_rx_overflow = false;
+}
+
+void link_poll(link_text_handler_t text) {
+    // Take whatever USB has buffered without waiting
+    uint8_t chunk[LINK_RX_CHUNK];
+    int n = stdio_get_until((char *)chunk, sizeof(chunk), get_absolute_time());
+    
+    for (int i = 0; i < n; i++) {
+        uint8_t b = chunk[i];
+        
+        if (b == 0) {
+            // Every delimiter ends the frame before it; one right after that frame opens the next
+            bool closing = link_rx_len || link_rx_overflow;
+            if (closing) link_frame_end();
+            link_rx_restart(!closing);
+            continue;
+        }
+        
+        // Keep every byte until the frame or line it belongs to is complete
+        if (link_rx_len < sizeof(link_rx)) link_rx[link_rx_len++] = b;
+        else link_rx_overflow = true;
+        bool line_end = b == '\n' || b == '\r';
+        if (!line_end && (b < 0x20 || b > 0x7E) && b != '\t') link_rx_text = false;
+        if (!line_end || link_rx_framed) continue;
+        
+        // A whole printable line outside a frame is text; a frame always holds a control byte
+        if (link_rx_overflow) {
+            link_errors++;
+            link_rx_restart(false);
+        } else if (link_rx_text) {
+            if (text)
+                for (uint32_t j = 0; j < link_rx_len; j++) text(link_rx[j]);
+            link_rx_restart(false);
+        }
+    }
+}
@@ -0,0 +1,131 @@
+/**
+ * @file link.h
+ * @brief Framed binary control protocol over USB CDC stdio
+ * @author Kevin Thomas
+ * @date 2025
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Kevin Thomas
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef LINK_H
+#define LINK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Largest decoded frame (type, sequence, body, CRC) in bytes
+#define LINK_FRAME_MAX 32
+
+// COBS adds one byte per 254 bytes, plus the delimiters on the wire
+#define LINK_WIRE_MAX (LINK_FRAME_MAX + LINK_FRAME_MAX / 254 + 3)
+
+// Longest frame or text line held until it is complete
+#define LINK_RX_MAX 64
+
+// Most bytes taken from USB per link_poll() call
+#define LINK_RX_CHUNK 64
+
+/**
+ * @brief Message types. Replies have bit 7 set.
+ *
+ * Every frame is: type (u8), sequence (u8), body, CRC-16/CCITT-FALSE of all
+ * preceding bytes (u16). Multi-byte fields are little-endian. The frame is
+ * COBS encoded and sent between two 0x00 delimiters, so text sent in either
+ * direction outside the delimiters stays readable.
+ */
+typedef enum {
+    LINK_MSG_DRIVE     = 0x01,  // Body: left (i16), right (i16); duty = value * 2, sign = direction
+    LINK_MSG_HEARTBEAT = 0x02,  // No body; keeps the current target alive
+    LINK_MSG_BRAKE     = 0x03,  // Body: brake time in milliseconds (u16)
+    LINK_MSG_TELEMETRY = 0x04,  // No body; asks for a LINK_REPLY_TELEMETRY
+    LINK_MSG_ARCADE    = 0x05,  // Body: throttle (i16), turn (i16); duty = value * 2, see motor_mix()
+    LINK_REPLY_TELEMETRY = 0x84 // Body: see link_telemetry_t
+} link_msg_t;
+
+/**
+ * @brief Body of a LINK_REPLY_TELEMETRY frame, in wire order.
+ */
+typedef struct {
+    uint32_t time_us;    // Robot time when the reply was built
+    int16_t left;        // Applied left duty / 2
+    int16_t right;       // Applied right duty / 2
+    uint8_t flags;       // LINK_FLAG_* bits
+    uint16_t frames;     // Valid frames received, wrapping
+    uint16_t errors;     // Frames dropped for bad framing, CRC or content, wrapping
+} link_telemetry_t;
+
+// Telemetry flag bits
+#define LINK_FLAG_FAILSAFE 0x01  // Failsafe has tripped since the last command
+#define LINK_FLAG_MOTION   0x02  // A motion sequence is running
+
+/**
+ * @brief Handler for bytes received outside binary frames.
+ *
+ * @param c  The character received.
+ */
+typedef void (*link_text_handler_t)(int c);
+
+/**
+ * @brief Take pending USB input and act on any complete frames (non-blocking).
+ *
+ * Every 0x00 ends the frame before it and starts a new one, so a lost
+ * delimiter costs one frame at most. Frames are COBS decoded in place in the
+ * receive buffer and parsed straight from it. Bytes outside a frame are only
+ * passed to the text handler once they make up a printable ASCII line ended by
+ * '\n' or '\r' that did not follow an opening delimiter; anything else is
+ * treated as frame data.
+ *
+ * @param text  Handler for text bytes, or NULL to drop them.
+ */
+void link_poll(link_text_handler_t text);
+
+/**
+ * @brief COBS encode a buffer.
+ *
+ * @param src      The bytes to encode.
+ * @param len      Number of bytes to encode.
+ * @param dst      Receives the encoded bytes, at least len + len / 254 + 1 long.
+ * @return size_t  Number of bytes written to dst (no delimiter).
+ */
+size_t link_cobs_encode(const uint8_t *src, size_t len, uint8_t *dst);
+
+/**
+ * @brief COBS decode a buffer in place.
+ *
+ * @param buf      The encoded bytes, without delimiters; overwritten with the result.
+ * @param len      Number of encoded bytes.
+ * @return int     Number of decoded bytes, or -1 if the encoding is invalid.
+ */
+int link_cobs_decode(uint8_t *buf, size_t len);
+
+/**
+ * @brief Compute a CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF).
+ *
+ * @param data       The bytes to check.
+ * @param len        Number of bytes.
+ * @return uint16_t  The CRC.
+ */
+uint16_t link_crc16(const uint8_t *data, size_t len);
+
+#endif // LINK_H
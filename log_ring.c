@@ -0,0 +1,145 @@
+/**
+ * @file log_ring.c
+ * @brief Implementation of the deferred binary event log
+ * @author Kevin Thomas
+ * @date 2025
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Kevin Thomas
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "log_ring.h"
+#include "pico/stdlib.h"
+#include "pico/stdio_usb.h"
+#include "tusb.h"
+#include <stdio.h>
+
+// Text format for each event identifier
+static const char *const log_formats[LOG_COUNT] = {
+    [LOG_FORWARD]     = "forward\n",
+    [LOG_LEFT]        = "left\n",
+    [LOG_STOP]        = "stop\n",
+    [LOG_RIGHT]       = "right\n",
+    [LOG_BACKWARD]    = "backward\n",
+    [LOG_SPEED]       = "speed: %lu\n",
+    [LOG_UNKNOWN_KEY] = "unknown key: 0x%02lX\n",
+    [LOG_RELEASE]     = "release\n",
+    [LOG_LATENCY]     = "max latency: %lu us\n",
+    [LOG_MACRO]       = "macro: %lu\n",
+    [LOG_BOOT]        = "boot: ready %lu us after reset\n",
+    [LOG_FIRST_KEY]   = "boot: first key %lu us after reset\n",
+};
+
+// Record storage
+static log_record_t log_records[LOG_RING_SIZE];
+
+// Next slot to write (producer) and to read (consumer)
+static atomic_uint log_head;
+static atomic_uint log_tail;
+
+// Records dropped in total, and how many of those were already reported
+static atomic_uint log_drops;
+static uint32_t log_drops_reported;
+
+void log_event(log_id_t id, uint32_t arg) {
+    // Only the producer writes head, so a relaxed load is enough
+    unsigned int head = atomic_load_explicit(&log_head, memory_order_relaxed);
+    unsigned int tail = atomic_load_explicit(&log_tail, memory_order_acquire);
+    
+    // Ring full, count the drop instead of waiting
+    if (head - tail >= LOG_RING_SIZE) {
+        atomic_fetch_add_explicit(&log_drops, 1, memory_order_relaxed);
+        return;
+    }
+    
+    // Store the record, then publish it by advancing head
+    log_record_t *rec = &log_records[head % LOG_RING_SIZE];
+    rec->time_us = time_us_32();
+    rec->arg = arg;
+    rec->id = (uint16_t)id;
+    atomic_store_explicit(&log_head, head + 1, memory_order_release);
+}
+
+/**
+ * @brief Format a record with its timestamp.
+ *
+ * @param rec   The record.
+ * @param line  Receives the text, always terminated.
+ * @return uint32_t  The length of the text.
+ */
+static uint32_t log_format(const log_record_t *rec, char line[LOG_LINE_MAX]) {
+    int n = snprintf(line, LOG_LINE_MAX, "[%10lu] ", (unsigned long)rec->time_us);
+    if (rec->id < LOG_COUNT)
+        n += snprintf(line + n, LOG_LINE_MAX - n, log_formats[rec->id], (unsigned long)rec->arg);
+    else
+        n += snprintf(line + n, LOG_LINE_MAX - n, "event %u: %lu\n", rec->id, (unsigned long)rec->arg);
+    return n < LOG_LINE_MAX ? (uint32_t)n : LOG_LINE_MAX - 1;
+}
+
+/**
+ * @brief Print a line only if the USB CDC transmit buffer can take all of it.
+ *
+ * stdio turns the newline into CRLF, so one extra byte is needed.
+ *
+ * @param line  The text.
+ * @param len   Its length.
+ * @return bool  true if printed, false if there was no room.
+ */
+static bool log_write(const char *line, uint32_t len) {
+    if (tud_cdc_write_available() < len + 1) return false;
+    printf("%s", line);
+    return true;
+}
+
+void log_drain(void) {
+    // Nothing can be shipped without a USB host
+    if (!stdio_usb_connected()) return;
+    
+    // Report drops once the backlog has been shipped
+    uint32_t drops = atomic_load_explicit(&log_drops, memory_order_relaxed);
+    char line[LOG_LINE_MAX];
+    
+    for (int i = 0; i < LOG_DRAIN_MAX; i++) {
+        // Only the consumer writes tail, so a relaxed load is enough
+        unsigned int tail = atomic_load_explicit(&log_tail, memory_order_relaxed);
+        unsigned int head = atomic_load_explicit(&log_head, memory_order_acquire);
+        
+        // Ring empty, report any drops and stop
+        if (head == tail) {
+            if (drops != log_drops_reported) {
+                int n = snprintf(line, sizeof(line), "log: %lu dropped\n", (unsigned long)(drops - log_drops_reported));
+                if (log_write(line, (uint32_t)n)) log_drops_reported = drops;
+            }
+            return;
+        }
+        
+        // Format the record, leaving it in the ring until the host has room for the line
+        log_record_t rec = log_records[tail % LOG_RING_SIZE];
+        if (!log_write(line, log_format(&rec, line))) return;
+        atomic_store_explicit(&log_tail, tail + 1, memory_order_release);
+    }
+}
+
+uint32_t log_dropped(void) {
+    // Total records dropped since boot
+    return atomic_load_explicit(&log_drops, memory_order_relaxed);
+}
@@ -0,0 +1,104 @@
+/**
+ * @file log_ring.h
+ * @brief Deferred binary event log that keeps printf off the control path
+ * @author Kevin Thomas
+ * @date 2025
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Kevin Thomas
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef LOG_RING_H
+#define LOG_RING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+// Ring capacity in records, must be a power of two
+#define LOG_RING_SIZE 64
+
+// Most records formatted per log_drain() call
+#define LOG_DRAIN_MAX 4
+
+// Longest formatted line, timestamp and newline included
+#define LOG_LINE_MAX 64
+
+/**
+ * @brief Log event identifiers; each one has a fixed text format in log_ring.c.
+ */
+typedef enum {
+    LOG_FORWARD,      // Forward command
+    LOG_LEFT,         // Left command
+    LOG_STOP,         // Stop command
+    LOG_RIGHT,        // Right command
+    LOG_BACKWARD,     // Backward command
+    LOG_SPEED,        // Speed changed, arg = new speed
+    LOG_UNKNOWN_KEY,  // Unknown key, arg = command byte
+    LOG_RELEASE,      // Key released
+    LOG_LATENCY,      // New worst key event to H-bridge output latency, arg = microseconds
+    LOG_MACRO,        // Motion macro started, arg = motion_macro_t
+    LOG_BOOT,         // Startup finished, arg = microseconds since reset
+    LOG_FIRST_KEY,    // First key accepted, arg = microseconds since reset
+    LOG_COUNT         // Number of event identifiers
+} log_id_t;
+
+/**
+ * @brief One compact binary log record.
+ */
+typedef struct {
+    uint32_t time_us;  // Time the event was logged
+    uint32_t arg;      // Event argument
+    uint16_t id;       // Event identifier (log_id_t)
+} log_record_t;
+
+/**
+ * @brief Record an event (single producer, never blocks).
+ *
+ * Stores a timestamped binary record in RAM. If the ring is full the record is
+ * dropped and counted instead of waiting.
+ *
+ * @param id   The event identifier.
+ * @param arg  The event argument.
+ */
+void log_event(log_id_t id, uint32_t arg);
+
+/**
+ * @brief Format and print pending records (single consumer, low priority).
+ *
+ * Prints at most LOG_DRAIN_MAX records, and only while a USB host is
+ * connected. Each record is formatted into a local buffer first and only
+ * printed when the USB CDC transmit buffer has room for the whole line;
+ * otherwise it stays in the ring for the next call. The caller therefore never
+ * stalls on a slow host or one that holds DTR without reading. Reports the
+ * number of dropped records once the ring has room again.
+ */
+void log_drain(void);
+
+/**
+ * @brief Get the number of records dropped because the ring was full.
+ *
+ * @return uint32_t  The total number of dropped records.
+ */
+uint32_t log_dropped(void);
+
+#endif // LOG_RING_H
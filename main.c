@@ -29,11 +29,85 @@
 
 #include <stdio.h>
 #include "pico/stdlib.h"
+#include "pico/multicore.h"
+#include "pico/flash.h"
+#include "hardware/sync.h"
 #include "robot.h"
+#include "control.h"
+#include "motion.h"
+#include "link.h"
+#include "recorder.h"
 #include "ir.h"
+#include "event_queue.h"
+#include "sched.h"
+#include "log_ring.h"
+#include "probe.h"
+
+// Key events from the IR decoder on core1 to the motion loop on core0
+static event_queue_t ir_events;
+
+// Startup phases, in the order init() reaches them
+typedef enum {
+    BOOT_MOTORS_SAFE,  // H-bridge pins driven, motors coasting
+    BOOT_CONTROL,      // Control tick running
+    BOOT_IR_ARMED,     // IR capture running
+    BOOT_CORE1,        // IR decoding on core1
+    BOOT_USB,          // USB stdio started (enumeration continues in the background)
+    BOOT_FIRST_KEY,    // First key event acted on
+    BOOT_PHASES        // Number of phases
+} boot_phase_t;
+
+// Time each phase was reached in microseconds since reset, 0 if not yet
+static uint32_t boot_us[BOOT_PHASES];
+static const char *const boot_names[BOOT_PHASES] = {
+    [BOOT_MOTORS_SAFE] = "motors safe",
+    [BOOT_CONTROL]     = "control tick",
+    [BOOT_IR_ARMED]    = "ir armed",
+    [BOOT_CORE1]       = "core1 decoding",
+    [BOOT_USB]         = "usb started",
+    [BOOT_FIRST_KEY]   = "first key",
+};
 
 static void init(void);
 static void loop(void);
+static void core1_main(void);
+static void sched_wait(uint32_t wake_us);
+static void task_ir_decode(void);
+static void task_ir_events(void);
+static void task_link(void);
+static void task_log(void);
+static void task_recorder(void);
+static void print_ir_stats(void);
+static void print_boot_times(void);
+static void usb_command(int c);
+
+// Core0 tasks, highest priority first; the control tick and failsafe run in a hardware alarm
+enum { TASK_CONTROL, TASK_IR_EVENTS, TASK_LINK, TASK_LOG, TASK_RECORDER, CORE0_TASKS };
+static sched_task_t core0_tasks[CORE0_TASKS] = {
+    [TASK_CONTROL]   = { "control",   NULL,           CONTROL_TICK_US, CONTROL_TICK_US },
+    [TASK_IR_EVENTS] = { "ir_events", task_ir_events, 0,               2000 },
+    [TASK_LINK]      = { "link",      task_link,      1000,            1000 },
+    [TASK_LOG]       = { "log",       task_log,       10000,           10000 },
+    [TASK_RECORDER]  = { "recorder",  task_recorder,  100000,          500000 },
+};
+static sched_t core0_sched;
+
+// Core1 tasks; between frames the core sleeps until the next IR edge instead
+enum { TASK_IR_DECODE, CORE1_TASKS };
+static sched_task_t core1_tasks[CORE1_TASKS] = {
+    [TASK_IR_DECODE] = { "ir_decode", task_ir_decode, 1000, 1000 },
+};
+static sched_t core1_sched;
+
+// Default speed at ~50% duty cycle
+static uint16_t speed = 32768;
+
+// Worst key event to H-bridge output latency seen so far
+static uint32_t max_latency_us;
+
+// USB text command being typed, e.g. "m -26214 26214 420000"
+static char usb_line[40];
+static uint32_t usb_line_len;
 
 int main() {
     init();
@@ -42,59 +116,232 @@ int main() {
 }
 
 static void init(void) {
-    // Initialize standard I/O for printf debugging
+    // Drive the H-bridge pins to a defined coasting state before anything else
+    motor_init();
+    boot_us[BOOT_MOTORS_SAFE] = time_us_32();
+
+    // Start the cycle counter for latency probes on core0
+    PROBE_INIT();
+
+    // Hand the motors to the 1 kHz control tick, reporting in the core0 task table
+    sched_init(&core0_sched, core0_tasks, CORE0_TASKS, time_us_32);
+    control_init(&core0_tasks[TASK_CONTROL]);
+    boot_us[BOOT_CONTROL] = time_us_32();
+
+    // Start background IR edge capture
+    ir_init();
+    boot_us[BOOT_IR_ARMED] = time_us_32();
+
+    // Resume the flight recorder before core1 starts recording edges
+    recorder_init();
+
+    // Hand IR decoding to core1
+    event_queue_init(&ir_events);
+    multicore_launch_core1(core1_main);
+    boot_us[BOOT_CORE1] = time_us_32();
+
+    // USB last; it does not wait for the host, enumeration finishes in the background
     stdio_init_all();
+    boot_us[BOOT_USB] = time_us_32();
+    log_event(LOG_BOOT, boot_us[BOOT_USB]);
+}
+
+static void core1_main(void) {
+    // Start the cycle counter for latency probes on core1
+    PROBE_INIT();
 
-    // Initialize motor control pins as outputs
-    gpio_init(AIN1); 
-    gpio_set_dir(AIN1, GPIO_OUT);
-    gpio_init(AIN2); 
-    gpio_set_dir(AIN2, GPIO_OUT);
-    gpio_init(BIN1); 
-    gpio_set_dir(BIN1, GPIO_OUT);
-    gpio_init(BIN2); 
-    gpio_set_dir(BIN2, GPIO_OUT);
+    // Let core0 pause this core while the flight recorder writes flash
+    flash_safe_execute_core_init();
+
+    // Let IR edges wake this core from sleep
+    ir_sleep_init();
+    sched_init(&core1_sched, core1_tasks, CORE1_TASKS, time_us_32);
+
+    // Decode while a frame is in progress or a key is held, otherwise sleep until an edge
+    while (1) {
+        uint32_t wake_us = sched_run(&core1_sched);
+
+        // An edge woke the core: decode it now rather than at the next grid time
+        if (ir_sleep()) sched_release(&core1_tasks[TASK_IR_DECODE], time_us_32());
+        else sched_wait(wake_us);
+    }
+}
+
+/**
+ * @brief Wait for the next task release, an event or an interrupt.
+ *
+ * @param wake_us  The time the next periodic task is due.
+ */
+static void sched_wait(uint32_t wake_us) {
+    // Edges keep collecting via DMA and the control tick keeps running meanwhile
+    int32_t wait_us = (int32_t)(wake_us - time_us_32());
+    if (wait_us > 0) best_effort_wfe_or_timeout(make_timeout_time_us((uint64_t)wait_us));
+}
+
+static void task_ir_decode(void) {
+    // Decode IR edges and forward timestamped key events to core0
+    ir_event_t ev;
+    while ((ev = ir_get_event()).type != IR_EVENT_NONE) {
+        // Drop the event if core0 has fallen a whole queue behind, then wake core0
+        event_queue_push(&ir_events, &ev);
+        __sev();
+    }
+}
+
+static void task_ir_events(void) {
+    // Act on every key event decoded on core1; releasing a motion key stops the robot
+    ir_event_t ev;
+    while (event_queue_pop(&ir_events, &ev)) {
+        // Process IR key event
+        recorder_key((uint8_t)ev.type, ev.key);
+        PROBE_START(event_start);
+        process_ir_event(ev, &speed);
+        PROBE_END(PROBE_IR_EVENT, event_start);
+        
+        // Time from reset to the first key acted on
+        if (!boot_us[BOOT_FIRST_KEY] && ev.type == IR_EVENT_PRESS) {
+            boot_us[BOOT_FIRST_KEY] = time_us_32();
+            log_event(LOG_FIRST_KEY, boot_us[BOOT_FIRST_KEY]);
+        }
+        
+        // Time from decode on core1 until the control tick changes the H-bridge outputs
+        control_stamp_event(ev.time_us);
+    }
     
-    // Initialize PWM outputs with 0 duty cycle (motors stopped)
-    setup_pwm(PWMA, 0);
-    setup_pwm(PWMB, 0);
-
-    // Initialize IR receiver pin as input with pull-up
-    gpio_init(IR_PIN); 
-    gpio_set_dir(IR_PIN, GPIO_IN);
-    gpio_pull_up(IR_PIN);
+    // Log each new worst latency the control tick has measured
+    uint32_t latency_us;
+    if (control_take_latency(&latency_us) && latency_us > max_latency_us) {
+        max_latency_us = latency_us;
+        log_event(LOG_LATENCY, max_latency_us);
+    }
 }
 
-static void loop(void) {
-    // Default speed at ~50% duty cycle
-    uint16_t speed = 32768;
+static void task_link(void) {
+    // Binary frames from a companion computer, text commands from a terminal
+    link_poll(usb_command);
+}
+
+static void task_log(void) {
+    // Ship a few deferred log records over USB
+    log_drain();
+}
+
+static void task_recorder(void) {
+    // Move staged recorder sectors to flash, only while standing still with no command in flight
+    recorder_service(control_idle() && !motion_busy());
+}
+
+static void print_ir_stats(void) {
+    // Report how long core1 slept waiting for IR and how quickly it woke
+    ir_sleep_stats_t st;
+    ir_get_sleep_stats(&st);
+    printf("core1 asleep: %llu us in %lu sleeps (%llu%% of uptime)\n",
+           (unsigned long long)st.sleep_us, (unsigned long)st.sleeps,
+           (unsigned long long)(st.sleep_us * 100 / time_us_64()));
+    printf("wake latency max: %lu us, wake to decode last/max: %lu/%lu us\n",
+           (unsigned long)st.wake_max_us, (unsigned long)st.decode_last_us,
+           (unsigned long)st.decode_max_us);
     
-    // Counter for auto-stop timeout
-    int n = 0;
+    // Report decoded frames and why the others were thrown away
+    ir_decode_stats_t ds;
+    ir_get_decode_stats(&ds);
+    printf("ir frames: %lu, glitches: %lu, rejected timing/length/checksum/address/repeat: %lu/%lu/%lu/%lu/%lu\n",
+           (unsigned long)ds.frames, (unsigned long)ds.glitches,
+           (unsigned long)ds.rejects[IR_REJECT_TIMING], (unsigned long)ds.rejects[IR_REJECT_LENGTH],
+           (unsigned long)ds.rejects[IR_REJECT_CHECKSUM], (unsigned long)ds.rejects[IR_REJECT_ADDRESS],
+           (unsigned long)ds.rejects[IR_REJECT_REPEAT]);
+}
 
-    // Main control loop
-    while (1) {
-        // Poll for IR remote commands
-        int key = ir_getkey();
+/**
+ * @brief Handle one character received over USB.
+ *
+ * Text reaches here a whole line at a time (see link_poll()), so commands run
+ * once Enter is pressed. 's' prints IR statistics, 'b' the startup phase
+ * times, 't' the task counters, 'p' the latency probes, 'r' dumps the flight
+ * recorder, 'g' starts the queued motion steps and 'x' cancels them. A line
+ * "m <left> <right> <us> [<accel> <decel>]" queues one motion step, with the
+ * duties clamped to +/-65535; a duration that is not positive is rejected.
+ *
+ * @param c  The character received.
+ */
+static void usb_command(int c) {
+    // Collect a motion step line until its end
+    if (usb_line_len || c == 'm') {
+        if (c != '\r' && c != '\n') {
+            if (usb_line_len < sizeof(usb_line) - 1) usb_line[usb_line_len++] = (char)c;
+            return;
+        }
+        usb_line[usb_line_len] = '\0';
+        usb_line_len = 0;
+        
+        // Parse and queue the step; ramps are optional, a duration must be positive
+        long left, right, duration_us;
+        unsigned long accel = 0, decel = 0;
+        if (sscanf(usb_line, "m %ld %ld %ld %lu %lu", &left, &right, &duration_us, &accel, &decel) < 3 || duration_us <= 0) {
+            printf("usage: m <left> <right> <us> [<accel> <decel>]\n");
+            return;
+        }
         
-        if (key >= 0) {
-            // Valid key received, reset timeout counter
-            n = 0;
+        // Clamp duties and ramps to what the motor layer and motion_step_t hold
+        left = left > 65535 ? 65535 : left < -65535 ? -65535 : left;
+        right = right > 65535 ? 65535 : right < -65535 ? -65535 : right;
+        accel = accel > 65535 ? 65535 : accel;
+        decel = decel > 65535 ? 65535 : decel;
+        motion_step_t step = { left, right, (uint32_t)duration_us, (uint16_t)accel, (uint16_t)decel };
+        if (!motion_push(&step)) printf("motion queue full\n");
+        return;
+    }
+    
+    switch (c) {
+        case 's': // IR statistics
+            print_ir_stats();
+            break;
             
-            // Process IR remote command
-            process_ir_command(key, &speed);
-        } else {
-            // No valid key received, increment timeout counter
-            n++;
+        case 'b': // Startup phase times
+            print_boot_times();
+            break;
             
-            // Auto-stop after ~800ms of no commands
-            if (n > 800) {
-                n = 0;
-                motor_stop();
-            }
+        case 't': // Per-task run time and deadline misses on both cores
+            sched_print(&core0_sched);
+            sched_print(&core1_sched);
+            break;
             
-            // Small delay between polls
-            sleep_ms(1);
-        }
+#if PROBES_ENABLED
+        case 'p': // Latency histograms
+            probe_dump();
+            break;
+#endif
+            
+        case 'r': // Flight recorder, replayable with tools/ir_replay.c
+            recorder_dump();
+            break;
+            
+        case 'g': // Run the queued motion steps
+            if (!motion_start()) printf("motion queue empty\n");
+            break;
+            
+        case 'x': // Cancel the motion sequence and stop
+            motion_cancel();
+            control_set_target(0, 0);
+            break;
+            
+        default: // Ignore anything else
+            break;
+    }
+}
+
+static void print_boot_times(void) {
+    // Report when each startup phase was reached
+    for (int i = 0; i < BOOT_PHASES; i++) {
+        if (boot_us[i]) printf("boot %-14s %8lu us\n", boot_names[i], (unsigned long)boot_us[i]);
+        else printf("boot %-14s        -\n", boot_names[i]);
+    }
+}
+
+static void loop(void) {
+    // Run due tasks, then sleep until core1 posts an event, an interrupt fires or a task is due
+    while (1) {
+        PROBE_PERIOD(PROBE_LOOP_PERIOD);
+        sched_wait(sched_run(&core0_sched));
     }
 }
@@ -0,0 +1,171 @@
+/**
+ * @file motion.c
+ * @brief Timed motion-primitive queue run from a hardware alarm
+ * @author Kevin Thomas
+ * @date 2025
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Kevin Thomas
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "motion.h"
+#include "control.h"
+#include "ramfunc.h"
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+
+// Built-in macro steps
+static const motion_step_t motion_left_90[] = {
+    { -MOTION_TURN_DUTY, MOTION_TURN_DUTY, MOTION_TURN_90_US, MOTION_MACRO_RAMP, MOTION_MACRO_RAMP },
+};
+static const motion_step_t motion_right_90[] = {
+    { MOTION_TURN_DUTY, -MOTION_TURN_DUTY, MOTION_TURN_90_US, MOTION_MACRO_RAMP, MOTION_MACRO_RAMP },
+};
+static const motion_step_t motion_leg[] = {
+    { MOTION_DRIVE_DUTY, MOTION_DRIVE_DUTY, MOTION_LEG_US, MOTION_MACRO_RAMP, MOTION_MACRO_RAMP },
+};
+static const motion_step_t motion_square[] = {
+    { MOTION_DRIVE_DUTY, MOTION_DRIVE_DUTY, MOTION_LEG_US, MOTION_MACRO_RAMP, MOTION_MACRO_RAMP },
+    { MOTION_TURN_DUTY, -MOTION_TURN_DUTY, MOTION_TURN_90_US, MOTION_MACRO_RAMP, MOTION_MACRO_RAMP },
+    { MOTION_DRIVE_DUTY, MOTION_DRIVE_DUTY, MOTION_LEG_US, MOTION_MACRO_RAMP, MOTION_MACRO_RAMP },
+    { MOTION_TURN_DUTY, -MOTION_TURN_DUTY, MOTION_TURN_90_US, MOTION_MACRO_RAMP, MOTION_MACRO_RAMP },
+    { MOTION_DRIVE_DUTY, MOTION_DRIVE_DUTY, MOTION_LEG_US, MOTION_MACRO_RAMP, MOTION_MACRO_RAMP },
+    { MOTION_TURN_DUTY, -MOTION_TURN_DUTY, MOTION_TURN_90_US, MOTION_MACRO_RAMP, MOTION_MACRO_RAMP },
+    { MOTION_DRIVE_DUTY, MOTION_DRIVE_DUTY, MOTION_LEG_US, MOTION_MACRO_RAMP, MOTION_MACRO_RAMP },
+    { MOTION_TURN_DUTY, -MOTION_TURN_DUTY, MOTION_TURN_90_US, MOTION_MACRO_RAMP, MOTION_MACRO_RAMP },
+};
+
+// Macro table indexed by motion_macro_t
+static const struct {
+    const motion_step_t *steps;
+    uint8_t count;
+} motion_macros[MOTION_MACRO_COUNT] = {
+    [MOTION_MACRO_LEFT_90]  = { motion_left_90, sizeof(motion_left_90) / sizeof(motion_left_90[0]) },
+    [MOTION_MACRO_RIGHT_90] = { motion_right_90, sizeof(motion_right_90) / sizeof(motion_right_90[0]) },
+    [MOTION_MACRO_LEG]      = { motion_leg, sizeof(motion_leg) / sizeof(motion_leg[0]) },
+    [MOTION_MACRO_SQUARE]   = { motion_square, sizeof(motion_square) / sizeof(motion_square[0]) },
+};
+
+// Queued steps; head is written by motion_push(), tail by the alarm
+static motion_step_t motion_queue[MOTION_QUEUE_SIZE];
+static volatile uint32_t motion_head;
+static volatile uint32_t motion_tail;
+
+// Alarm running the sequence, 0 when idle
+static volatile alarm_id_t motion_alarm_id;
+
+// Time left in the current step after the pending alarm
+static uint32_t motion_remaining_us;
+
+/**
+ * @brief Step boundary alarm: start the next step or keep the current one alive.
+ *
+ * @param id         The alarm (unused).
+ * @param user_data  Unused.
+ * @return int64_t   Negative delay to the next boundary, measured from this
+ *                   alarm's scheduled time, or 0 when the sequence is over.
+ */
+static int64_t RAM_FUNC(motion_alarm)(alarm_id_t id, void *user_data) {
+    (void)id;
+    (void)user_data;
+    
+    if (motion_remaining_us) {
+        // Middle of a long step, only restart the failsafe deadline
+        control_feed();
+    } else if (motion_tail != motion_head) {
+        // Next step: ramp, target and how long to hold it
+        const motion_step_t *step = &motion_queue[motion_tail % MOTION_QUEUE_SIZE];
+        if (step->accel || step->decel)
+            control_set_ramp(step->accel ? step->accel : CONTROL_ACCEL_DEFAULT,
+                             step->decel ? step->decel : CONTROL_DECEL_DEFAULT);
+        control_set_target(step->left, step->right);
+        motion_remaining_us = step->duration_us;
+        motion_tail = motion_tail + 1;
+    } else {
+        // Out of steps, ramp to a stop with the default ramp
+        control_set_ramp(CONTROL_ACCEL_DEFAULT, CONTROL_DECEL_DEFAULT);
+        control_set_target(0, 0);
+        motion_alarm_id = 0;
+        return 0;
+    }
+    
+    // Wake at the step boundary, or earlier to feed the failsafe again
+    uint32_t wait_us = motion_remaining_us < MOTION_FEED_US ? motion_remaining_us : MOTION_FEED_US;
+    motion_remaining_us -= wait_us;
+    return -(int64_t)wait_us;
+}
+
+bool motion_push(const motion_step_t *step) {
+    // Full when the producer is a whole ring ahead of the alarm
+    if (motion_head - motion_tail >= MOTION_QUEUE_SIZE) return false;
+    
+    // Store the step, then publish it by advancing head; a zero duration would end the alarm
+    motion_step_t *slot = &motion_queue[motion_head % MOTION_QUEUE_SIZE];
+    *slot = *step;
+    if (slot->duration_us == 0) slot->duration_us = 1;
+    __dmb();
+    motion_head = motion_head + 1;
+    return true;
+}
+
+bool motion_start(void) {
+    // Already running, new steps are picked up at the next boundary
+    if (motion_alarm_id > 0) return true;
+    if (motion_head == motion_tail) return false;
+    
+    // First boundary shortly from now; later ones are chained off this one
+    uint32_t save = save_and_disable_interrupts();
+    motion_remaining_us = 0;
+    alarm_id_t id = add_alarm_in_us(MOTION_START_US, motion_alarm, NULL, true);
+    motion_alarm_id = id > 0 ? id : 0;
+    restore_interrupts(save);
+    return id >= 0;
+}
+
+void motion_cancel(void) {
+    // Cancel the alarm and drop its id in one go, so it cannot fire in between and start another step
+    uint32_t save = save_and_disable_interrupts();
+    alarm_id_t id = motion_alarm_id;
+    if (id > 0) cancel_alarm(id);
+    motion_alarm_id = 0;
+    
+    // Drop anything left
+    motion_tail = motion_head;
+    motion_remaining_us = 0;
+    restore_interrupts(save);
+    if (id > 0) control_set_ramp(CONTROL_ACCEL_DEFAULT, CONTROL_DECEL_DEFAULT);
+}
+
+bool motion_busy(void) {
+    // The alarm clears its id when the queue runs dry
+    return motion_alarm_id > 0;
+}
+
+bool motion_run_macro(motion_macro_t macro) {
+    if (macro >= MOTION_MACRO_COUNT) return false;
+    
+    // Replace whatever was running with the macro's steps
+    motion_cancel();
+    for (uint8_t i = 0; i < motion_macros[macro].count; i++)
+        if (!motion_push(&motion_macros[macro].steps[i])) return false;
+    return motion_start();
+}
@@ -0,0 +1,130 @@
+/**
+ * @file motion.h
+ * @brief Timed motion-primitive queue run from a hardware alarm
+ * @author Kevin Thomas
+ * @date 2025
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Kevin Thomas
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef MOTION_H
+#define MOTION_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Queue capacity in steps, must be a power of two
+#define MOTION_QUEUE_SIZE 16
+
+// Longest wait between alarms; long steps are split to keep feeding the control failsafe
+#define MOTION_FEED_US 250000
+
+// Delay from motion_start() to the first step
+#define MOTION_START_US 20
+
+// Time a macro turns in place at MOTION_TURN_DUTY to rotate 90 degrees (calibrate per robot)
+#ifndef MOTION_TURN_90_US
+#define MOTION_TURN_90_US 420000
+#endif
+
+// Time a macro drives straight for one leg at MOTION_DRIVE_DUTY
+#ifndef MOTION_LEG_US
+#define MOTION_LEG_US 1000000
+#endif
+
+// Duties used by the built-in macros (~40% and ~50%)
+#define MOTION_TURN_DUTY  26214
+#define MOTION_DRIVE_DUTY 32768
+
+// Ramp used by the built-in macros, full duty in ~65ms so turns stay repeatable
+#define MOTION_MACRO_RAMP 1000
+
+/**
+ * @brief One motion primitive: hold a per-wheel duty for a fixed time.
+ */
+typedef struct {
+    int32_t left;          // Left duty (-65535 to 65535), the sign is the direction
+    int32_t right;         // Right duty (-65535 to 65535), the sign is the direction
+    uint32_t duration_us;  // Time until the next step starts
+    uint16_t accel;        // Ramp while speeding up, duty per control tick (0 = unchanged)
+    uint16_t decel;        // Ramp while slowing down, duty per control tick (0 = unchanged)
+} motion_step_t;
+
+/**
+ * @brief Built-in motion sequences.
+ */
+typedef enum {
+    MOTION_MACRO_LEFT_90,   // Turn 90 degrees left in place
+    MOTION_MACRO_RIGHT_90,  // Turn 90 degrees right in place
+    MOTION_MACRO_LEG,       // Drive one leg straight ahead
+    MOTION_MACRO_SQUARE,    // Drive a square, turning right at each corner
+    MOTION_MACRO_COUNT      // Number of macros
+} motion_macro_t;
+
+/**
+ * @brief Append a step to the queue (core0 only).
+ *
+ * Steps may be added while a sequence is running; they run after the steps
+ * already queued.
+ *
+ * @param step   The step to copy into the queue.
+ * @return bool  true on success, false if the queue is full.
+ */
+bool motion_push(const motion_step_t *step);
+
+/**
+ * @brief Start running the queued steps (core0 only).
+ *
+ * Each step boundary is a hardware alarm scheduled relative to the previous
+ * boundary, so step timing does not drift and does not depend on how busy the
+ * main loop is. Once the queue runs dry the robot ramps to a stop and the
+ * control ramp returns to its defaults.
+ *
+ * @return bool  true if the sequence started or was already running, false if
+ *               the queue is empty.
+ */
+bool motion_start(void);
+
+/**
+ * @brief Stop running steps and empty the queue (core0 only).
+ *
+ * Leaves the motor target alone so that the caller's next command takes over.
+ */
+void motion_cancel(void);
+
+/**
+ * @brief Check whether a sequence is running.
+ *
+ * @return bool  true while queued steps are being executed.
+ */
+bool motion_busy(void);
+
+/**
+ * @brief Replace any running sequence with a built-in one and start it (core0 only).
+ *
+ * @param macro  The macro to run.
+ * @return bool  true if the macro started.
+ */
+bool motion_run_macro(motion_macro_t macro);
+
+#endif // MOTION_H
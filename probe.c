@@ -0,0 +1,121 @@
+/**
+ * @file probe.c
+ * @brief Implementation of the latency instrumentation probes
+ * @author Kevin Thomas
+ * @date 2025
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Kevin Thomas
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "probe.h"
+#include "ramfunc.h"
+
+#if PROBES_ENABLED
+
+#include "pico/stdlib.h"
+#include "hardware/structs/m33.h"
+#include <stdio.h>
+
+// Probe names and units for probe_dump()
+static const char *const probe_names[PROBE_COUNT] = {
+    [PROBE_IR_POLL]       = "ir_poll      cyc",
+    [PROBE_IR_EDGE]       = "ir_edge      cyc",
+    [PROBE_IR_EVENT]      = "ir_event     cyc",
+    [PROBE_MOTOR_SET]     = "motor_set    cyc",
+    [PROBE_CONTROL_TICK]  = "control_tick cyc",
+    [PROBE_TICK_PERIOD]   = "tick_period  us ",
+    [PROBE_LOOP_PERIOD]   = "loop_period  us ",
+    [PROBE_EVENT_LATENCY] = "event_lat    us ",
+};
+
+// One histogram per probe
+static probe_hist_t probe_hists[PROBE_COUNT];
+
+void probe_init(void) {
+    // Enable the DWT unit and its cycle counter on this core
+    m33_hw->demcr |= M33_DEMCR_TRCENA_BITS;
+    m33_hw->dwt_cyccnt = 0;
+    m33_hw->dwt_ctrl |= M33_DWT_CTRL_CYCCNTENA_BITS;
+}
+
+uint32_t RAM_FUNC(probe_cycles)(void) {
+    // Current cycle count of this core
+    return m33_hw->dwt_cyccnt;
+}
+
+void RAM_FUNC(probe_record)(probe_id_t id, uint32_t value) {
+    probe_hist_t *h = &probe_hists[id];
+    
+    // Track the exact extremes
+    if (h->count == 0 || value < h->min) h->min = value;
+    if (value > h->max) h->max = value;
+    h->count++;
+    
+    // Bucket by bit length (0 goes to bucket 0)
+    h->buckets[value ? 32 - __builtin_clz(value) : 0]++;
+}
+
+/**
+ * @brief Find the bucket holding a given percentile.
+ *
+ * @param h    The histogram to search.
+ * @param pct  The percentile (0-100).
+ * @return uint32_t  The largest value the bucket can hold.
+ */
+static uint32_t probe_percentile(const probe_hist_t *h, uint32_t pct) {
+    // Number of samples at or below the percentile (rounded up)
+    uint64_t rank = ((uint64_t)h->count * pct + 99) / 100;
+    uint64_t seen = 0;
+    
+    // Walk buckets until enough samples have been passed
+    for (int b = 0; b < PROBE_BUCKETS; b++) {
+        seen += h->buckets[b];
+        if (seen >= rank)
+            return b ? (uint32_t)((1ull << b) - 1) : 0;
+    }
+    return h->max;
+}
+
+void probe_dump(void) {
+    // Header matching the columns below
+    printf("probe            unit      count        min        p50        p99        max\n");
+    
+    // One line per probe that has samples
+    for (int i = 0; i < PROBE_COUNT; i++) {
+        const probe_hist_t *h = &probe_hists[i];
+        if (h->count == 0) continue;
+        
+        uint32_t p50 = probe_percentile(h, 50);
+        uint32_t p99 = probe_percentile(h, 99);
+        
+        // Bucket bounds can overshoot the real extremes
+        if (p50 > h->max) p50 = h->max;
+        if (p99 > h->max) p99 = h->max;
+        
+        printf("%s %10lu %10lu %10lu %10lu %10lu\n", probe_names[i],
+               (unsigned long)h->count, (unsigned long)h->min,
+               (unsigned long)p50, (unsigned long)p99, (unsigned long)h->max);
+    }
+}
+
+#endif // PROBES_ENABLED
@@ -0,0 +1,130 @@
+/**
+ * @file probe.h
+ * @brief Latency instrumentation probes with fixed-bucket histograms
+ * @author Kevin Thomas
+ * @date 2025
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Kevin Thomas
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef PROBE_H
+#define PROBE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Probes are compiled in only when the build enables them (cmake -DC_ROBOT_PROBES=ON)
+#ifndef PROBES_ENABLED
+#define PROBES_ENABLED 0
+#endif
+
+// One bucket per power of two: bucket n holds values in [2^(n-1), 2^n)
+#define PROBE_BUCKETS 33
+
+/**
+ * @brief Instrumented code paths.
+ */
+typedef enum {
+    PROBE_IR_POLL,        // One ir_poll() call on core1 (cycles)
+    PROBE_IR_EDGE,        // Decoding one captured edge (cycles)
+    PROBE_IR_EVENT,       // process_ir_event() on core0 (cycles)
+    PROBE_MOTOR_SET,      // Motor update from the control tick (cycles)
+    PROBE_CONTROL_TICK,   // One whole control tick (cycles)
+    PROBE_TICK_PERIOD,    // Time between control ticks (us)
+    PROBE_LOOP_PERIOD,    // Time between core0 loop iterations (us)
+    PROBE_EVENT_LATENCY,  // Key event detected on core1 to the control tick changing the H-bridge outputs (us)
+    PROBE_COUNT           // Number of probes
+} probe_id_t;
+
+/**
+ * @brief Latency histogram for one probe.
+ */
+typedef struct {
+    uint32_t count;                   // Number of samples
+    uint32_t min;                     // Smallest sample
+    uint32_t max;                     // Largest sample
+    uint32_t buckets[PROBE_BUCKETS];  // Samples per power-of-two bucket
+} probe_hist_t;
+
+#if PROBES_ENABLED
+
+#include "pico/time.h"
+
+/**
+ * @brief Start the cycle counter on the calling core.
+ *
+ * Each core has its own counter, so this must run once on every core that
+ * records cycle-based probes.
+ */
+void probe_init(void);
+
+/**
+ * @brief Read the cycle counter of the calling core.
+ *
+ * @return uint32_t  The current cycle count.
+ */
+uint32_t probe_cycles(void);
+
+/**
+ * @brief Add one sample to a probe histogram.
+ *
+ * Each probe must only be recorded from one core and one execution context.
+ *
+ * @param id     The probe to record.
+ * @param value  The sample, in the unit of that probe.
+ */
+void probe_record(probe_id_t id, uint32_t value);
+
+/**
+ * @brief Print count, min, p50, p99 and max of every probe over stdio.
+ *
+ * Percentiles are reported as the upper bound of the bucket they fall in.
+ */
+void probe_dump(void);
+
+// Measure the cycles spent between PROBE_START(var) and PROBE_END(id, var)
+#define PROBE_START(var)      uint32_t var = probe_cycles()
+#define PROBE_END(id, var)    probe_record((id), probe_cycles() - (var))
+#define PROBE_RECORD(id, val) probe_record((id), (val))
+#define PROBE_INIT()          probe_init()
+
+// Record the microseconds since this line last ran
+#define PROBE_PERIOD(id) do { \
+        static uint32_t probe_last_us; \
+        uint32_t probe_now_us = time_us_32(); \
+        if (probe_last_us) probe_record((id), probe_now_us - probe_last_us); \
+        probe_last_us = probe_now_us; \
+    } while (0)
+
+#else
+
+// Release builds, every probe compiles to nothing
+#define PROBE_START(var)      do { } while (0)
+#define PROBE_END(id, var)    do { } while (0)
+#define PROBE_RECORD(id, val) do { } while (0)
+#define PROBE_INIT()          do { } while (0)
+#define PROBE_PERIOD(id)      do { } while (0)
+
+#endif // PROBES_ENABLED
+
+#endif // PROBE_H
@@ -0,0 +1,54 @@
+/**
+ * @file ramfunc.h
+ * @brief Placement of timing-critical functions in SRAM
+ * @author Kevin Thomas
+ * @date 2025
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Kevin Thomas
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef RAMFUNC_H
+#define RAMFUNC_H
+
+// Hot paths run from SRAM only when the build asks for it (cmake -DC_ROBOT_RAM_HOT_PATHS=ON)
+#ifndef RAM_HOT_PATHS
+#define RAM_HOT_PATHS 0
+#endif
+
+/**
+ * @brief Wrap the name in a timing-critical function definition.
+ *
+ * With RAM_HOT_PATHS the function is linked into SRAM, so an XIP cache miss
+ * can never stall it; otherwise it stays in flash like any other function.
+ * Only the definition is wrapped: void RAM_FUNC(name)(args) { ... }. Static
+ * inline helpers are only covered once inlined, so hot-path builds should be
+ * optimised (Release).
+ */
+#if RAM_HOT_PATHS
+#include "pico/platform.h"
+#define RAM_FUNC(name) __not_in_flash_func(name)
+#else
+#define RAM_FUNC(name) name
+#endif
+
+#endif // RAMFUNC_H
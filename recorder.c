@@ -0,0 +1,376 @@
+/**
+ * @file recorder.c
+ * @brief Flash-backed flight recorder for IR edges, key events and motor commands
+ * @author Kevin Thomas
+ * @date 2025
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Kevin Thomas
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "recorder.h"
+#include "ir.h"
+#include "ramfunc.h"
+#include "pico/stdlib.h"
+#include "pico/flash.h"
+#include "hardware/flash.h"
+#include "hardware/sync.h"
+
+// Longest record: type, time delta and two 5-byte varints
+#define RECORDER_RECORD_MAX 16
+
+// Flash offset of the reserved region, the last RECORDER_FLASH_SECTORS of flash
+#define RECORDER_FLASH_OFFSET (PICO_FLASH_SIZE_BYTES - RECORDER_FLASH_SECTORS * RECORDER_SECTOR_SIZE)
+
+_Static_assert(RECORDER_SECTOR_SIZE == FLASH_SECTOR_SIZE, "recorder sectors must match flash sectors");
+_Static_assert(sizeof(recorder_header_t) == 16, "recorder header must stay 16 bytes");
+
+// End of the program image in flash, from the linker script
+extern char __flash_binary_end;
+
+// Sectors waiting for flash; the one at recorder_head is being filled
+static uint8_t recorder_ram[RECORDER_RAM_SECTORS][RECORDER_SECTOR_SIZE] __attribute__((aligned(4)));
+
+// Free-running RAM sector counts: head is being filled, tail is the oldest not yet in flash
+static uint32_t recorder_head;
+static uint32_t recorder_tail;
+
+// Bytes used in the head sector and the time of its last record
+static uint32_t recorder_used;
+static uint32_t recorder_last_us;
+
+// Sequence number for the next sector opened
+static uint32_t recorder_seq;
+
+// Free-running count of flash sectors written, the next one is reused oldest first
+static uint32_t recorder_flash_next;
+
+// Sectors overwritten in RAM before they reached flash
+static uint32_t recorder_lost;
+
+// Serializes records from both cores and the alarm interrupts
+static spin_lock_t *recorder_lock;
+
+// Set once recorder_init() has a sector open; stays clear if the region overlaps the program image
+static volatile bool recorder_enabled;
+
+/**
+ * @brief Append an unsigned LEB128 varint.
+ *
+ * @param p      Where to write, at least 5 bytes.
+ * @param value  The value to encode.
+ * @return uint32_t  The number of bytes written.
+ */
+static uint32_t RAM_FUNC(recorder_varint)(uint8_t *p, uint32_t value) {
+    uint32_t n = 0;
+    while (value >= 0x80) {
+        p[n++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    p[n++] = (uint8_t)value;
+    return n;
+}
+
+/**
+ * @brief Map a signed value to unsigned so small magnitudes stay short.
+ *
+ * @param value  The value to encode.
+ * @return uint32_t  The zigzag encoded value.
+ */
+static inline uint32_t recorder_zigzag(int32_t value) {
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+/**
+ * @brief Start a new head sector (lock held).
+ *
+ * @param now_us  The time the sector's first delta is measured from.
+ */
+static void RAM_FUNC(recorder_open)(uint32_t now_us) {
+    recorder_header_t *hdr = (recorder_header_t *)recorder_ram[recorder_head % RECORDER_RAM_SECTORS];
+    hdr->magic = RECORDER_MAGIC;
+    hdr->seq = recorder_seq++;
+    hdr->base_us = now_us;
+    hdr->used = sizeof(recorder_header_t);
+    hdr->reserved = 0xFFFF;
+    recorder_used = sizeof(recorder_header_t);
+    recorder_last_us = now_us;
+}
+
+/**
+ * @brief Close the head sector for flash and open the next (lock held).
+ *
+ * @param now_us  The current time.
+ */
+static void RAM_FUNC(recorder_close)(uint32_t now_us) {
+    // Pad with erased bytes so the flash copy matches what a blank sector holds; volatile
+    // stores so the loop cannot become a call to the library memset in flash
+    uint8_t *buf = recorder_ram[recorder_head % RECORDER_RAM_SECTORS];
+    ((recorder_header_t *)buf)->used = (uint16_t)recorder_used;
+    volatile uint8_t *pad = buf;
+    for (uint32_t i = recorder_used; i < RECORDER_SECTOR_SIZE; i++) pad[i] = 0xFF;
+    
+    // Keep the newest data; drop the oldest staged sector if flash has fallen behind
+    recorder_head++;
+    if (recorder_head - recorder_tail >= RECORDER_RAM_SECTORS) {
+        recorder_tail++;
+        recorder_lost++;
+    }
+    recorder_open(now_us);
+}
+
+/**
+ * @brief Append one record with its time delta.
+ *
+ * @param type     The record type.
+ * @param payload  The encoded payload.
+ * @param len      The payload length in bytes.
+ */
+static void RAM_FUNC(recorder_put)(recorder_type_t type, const uint8_t *payload, uint32_t len) {
+    if (!recorder_enabled) return;
+    uint32_t save = spin_lock_blocking(recorder_lock);
+    uint32_t now_us = time_us_32();
+    
+    // Roll over to a fresh sector when this record might not fit
+    if (recorder_used + RECORDER_RECORD_MAX > RECORDER_SECTOR_SIZE) recorder_close(now_us);
+    
+    // Type, time since the previous record, then the payload
+    uint8_t *p = recorder_ram[recorder_head % RECORDER_RAM_SECTORS] + recorder_used;
+    uint32_t n = 0;
+    p[n++] = (uint8_t)type;
+    n += recorder_varint(p + n, now_us - recorder_last_us);
+    volatile uint8_t *dst = p + n;
+    for (uint32_t i = 0; i < len; i++) dst[i] = payload[i];
+    recorder_used += n + len;
+    recorder_last_us = now_us;
+    
+    spin_unlock(recorder_lock, save);
+}
+
+void recorder_init(void) {
+    // The region must lie wholly past the program image
+    recorder_lock = spin_lock_init(spin_lock_claim_unused(true));
+    bool enabled = (uint32_t)((uintptr_t)&__flash_binary_end - XIP_BASE) <= RECORDER_FLASH_OFFSET;
+    if (!enabled) return;
+    
+    // Resume after the newest sector written before this boot
+    uint32_t newest = 0;
+    bool found = false;
+    for (uint32_t i = 0; i < RECORDER_FLASH_SECTORS; i++) {
+        const recorder_header_t *hdr = (const recorder_header_t *)
+            ((uintptr_t)(XIP_BASE + RECORDER_FLASH_OFFSET + i * RECORDER_SECTOR_SIZE));
+        if (hdr->magic == RECORDER_MAGIC && (!found || (int32_t)(hdr->seq - recorder_seq) >= 0)) {
+            recorder_seq = hdr->seq + 1;
+            newest = i;
+            found = true;
+        }
+    }
+    recorder_flash_next = found ? newest + 1 : 0;
+    recorder_open(time_us_32());
+    
+    // Only now let the control alarm and core1 append, once the sector is ready
+    __dmb();
+    recorder_enabled = true;
+}
+
+void RAM_FUNC(recorder_edge)(uint32_t edge) {
+    // Width in the low bits, the level in bit 0
+    uint32_t high = (edge & IR_EDGE_HIGH) != 0;
+    uint32_t width = high ? ~edge : edge;
+    uint8_t payload[5];
+    recorder_put(RECORDER_EDGE, payload, recorder_varint(payload, (width << 1) | high));
+}
+
+void recorder_key(uint8_t type, uint8_t key) {
+    uint8_t payload[2] = { type, key };
+    recorder_put(RECORDER_KEY, payload, sizeof(payload));
+}
+
+void RAM_FUNC(recorder_motor)(int32_t left, int32_t right) {
+    uint8_t payload[10];
+    uint32_t n = recorder_varint(payload, recorder_zigzag(left));
+    n += recorder_varint(payload + n, recorder_zigzag(right));
+    recorder_put(RECORDER_MOTOR, payload, n);
+}
+
+void recorder_brake(uint32_t brake_ms) {
+    uint8_t payload[5];
+    recorder_put(RECORDER_BRAKE, payload, recorder_varint(payload, brake_ms));
+}
+
+void RAM_FUNC(recorder_failsafe)(void) {
+    recorder_put(RECORDER_FAILSAFE, NULL, 0);
+}
+
+/**
+ * @brief Erase the next flash sector and program the oldest staged one into it.
+ *
+ * Runs with core1 paused and interrupts off on core0, so no record can land
+ * in the sector while it is copied.
+ *
+ * @param param  Unused.
+ */
+static void recorder_write_sector(void *param) {
+    (void)param;
+    uint32_t offset = RECORDER_FLASH_OFFSET +
+                      (recorder_flash_next % RECORDER_FLASH_SECTORS) * RECORDER_SECTOR_SIZE;
+    flash_range_erase(offset, RECORDER_SECTOR_SIZE);
+    flash_range_program(offset, recorder_ram[recorder_tail % RECORDER_RAM_SECTORS], RECORDER_SECTOR_SIZE);
+    recorder_flash_next++;
+    recorder_tail++;
+}
+
+void recorder_service(bool idle) {
+    // Erasing stalls both cores, only do it while the robot stands still
+    if (!recorder_enabled || !idle) return;
+    
+    // Full sectors first; a partly filled one once the robot has been quiet a while
+    uint32_t save = spin_lock_blocking(recorder_lock);
+    bool ready = recorder_head != recorder_tail;
+    if (!ready && recorder_used > sizeof(recorder_header_t) &&
+        time_us_32() - recorder_last_us >= RECORDER_IDLE_FLUSH_US) {
+        recorder_close(time_us_32());
+        ready = true;
+    }
+    spin_unlock(recorder_lock, save);
+    
+    // Left staged and retried next time if core1 cannot be paused
+    if (ready) flash_safe_execute(recorder_write_sector, NULL, RECORDER_LOCKOUT_MS);
+}
+
+/**
+ * @brief Read one unsigned LEB128 varint, stopping at the end of the data.
+ *
+ * @param buf   The sector.
+ * @param i     The read position, advanced past the varint.
+ * @param used  The bytes in use.
+ * @return uint32_t  The decoded value.
+ */
+static uint32_t recorder_read_varint(const uint8_t *buf, uint32_t *i, uint32_t used) {
+    uint32_t value = 0;
+    for (uint32_t shift = 0; *i < used && shift < 35; shift += 7) {
+        uint8_t b = buf[(*i)++];
+        value |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) break;
+    }
+    return value;
+}
+
+/**
+ * @brief Undo recorder_zigzag().
+ *
+ * @param value  The zigzag encoded value.
+ * @return int32_t  The signed value.
+ */
+static inline int32_t recorder_unzigzag(uint32_t value) {
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+/**
+ * @brief Print the records of one sector with absolute times.
+ *
+ * @param buf   The sector, header first.
+ * @param used  The bytes in use, header included.
+ */
+static void recorder_print_sector(const uint8_t *buf, uint32_t used) {
+    const recorder_header_t *hdr = (const recorder_header_t *)buf;
+    printf("S %lu\n", (unsigned long)hdr->seq);
+    
+    // Walk the records, accumulating time deltas
+    uint32_t time_us = hdr->base_us;
+    uint32_t i = sizeof(recorder_header_t);
+    while (i < used) {
+        uint8_t type = buf[i++];
+        time_us += recorder_read_varint(buf, &i, used);
+        
+        switch (type) {
+            case RECORDER_EDGE: { // Rebuild the capture word the decoder expects
+                uint32_t v = recorder_read_varint(buf, &i, used);
+                printf("E %lu %08lx\n", (unsigned long)time_us,
+                       (unsigned long)((v & 1) ? ~(v >> 1) : (v >> 1)));
+                break;
+            }
+                
+            case RECORDER_KEY: // Event type and command byte
+                if (i + 2 > used) return;
+                printf("K %lu %u %02x\n", (unsigned long)time_us, buf[i], buf[i + 1]);
+                i += 2;
+                break;
+                
+            case RECORDER_MOTOR: { // Left then right target duty
+                int32_t left = recorder_unzigzag(recorder_read_varint(buf, &i, used));
+                int32_t right = recorder_unzigzag(recorder_read_varint(buf, &i, used));
+                printf("M %lu %ld %ld\n", (unsigned long)time_us, (long)left, (long)right);
+                break;
+            }
+                
+            case RECORDER_BRAKE: // Brake time in milliseconds
+                printf("B %lu %lu\n", (unsigned long)time_us,
+                       (unsigned long)recorder_read_varint(buf, &i, used));
+                break;
+                
+            case RECORDER_FAILSAFE: // Failsafe stop
+                printf("F %lu\n", (unsigned long)time_us);
+                break;
+                
+            default: // Corrupt sector, skip the rest
+                return;
+        }
+    }
+}
+
+void recorder_dump(void) {
+    if (!recorder_enabled) {
+        printf("# recorder disabled: program overlaps the flash region\n");
+        return;
+    }
+    printf("# recorder: %lu sectors written, %lu lost\n",
+           (unsigned long)recorder_flash_next, (unsigned long)recorder_lost);
+    
+    // Flash sectors oldest first, starting just after the newest
+    for (uint32_t i = 0; i < RECORDER_FLASH_SECTORS; i++) {
+        const uint8_t *buf = (const uint8_t *)(uintptr_t)(XIP_BASE + RECORDER_FLASH_OFFSET +
+            ((recorder_flash_next + i) % RECORDER_FLASH_SECTORS) * RECORDER_SECTOR_SIZE);
+        const recorder_header_t *hdr = (const recorder_header_t *)buf;
+        if (hdr->magic == RECORDER_MAGIC && hdr->used <= RECORDER_SECTOR_SIZE)
+            recorder_print_sector(buf, hdr->used);
+    }
+    
+    // Then what is still staged in RAM, copied under the lock so records keep arriving
+    static uint8_t copy[RECORDER_SECTOR_SIZE];
+    uint32_t sector = recorder_tail;
+    while (1) {
+        uint32_t save = spin_lock_blocking(recorder_lock);
+        if ((int32_t)(sector - recorder_tail) < 0) sector = recorder_tail;
+        bool last = sector == recorder_head;
+        const uint8_t *buf = recorder_ram[sector % RECORDER_RAM_SECTORS];
+        uint32_t used = last ? recorder_used : ((const recorder_header_t *)buf)->used;
+        memcpy(copy, buf, used);
+        spin_unlock(recorder_lock, save);
+        
+        recorder_print_sector(copy, used);
+        if (last) break;
+        sector++;
+    }
+}
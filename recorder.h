@@ -0,0 +1,145 @@
+/**
+ * @file recorder.h
+ * @brief Flash-backed flight recorder for IR edges, key events and motor commands
+ * @author Kevin Thomas
+ * @date 2025
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Kevin Thomas
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Flash erase unit; records are staged and written in whole sectors
+#define RECORDER_SECTOR_SIZE 4096
+
+// Flash sectors reserved at the very end of flash (256 KB), reused oldest first
+#define RECORDER_FLASH_SECTORS 64
+
+// RAM staging sectors; the oldest unwritten one is overwritten when all are full
+#define RECORDER_RAM_SECTORS 4
+
+// A partly filled sector is written once nothing was recorded for this long while idle
+#define RECORDER_IDLE_FLUSH_US 2000000
+
+// Longest wait for core1 to pause before a flash write is skipped
+#define RECORDER_LOCKOUT_MS 10
+
+// Marks a sector holding recorder data ("CRFR")
+#define RECORDER_MAGIC 0x52464352u
+
+/**
+ * @brief Record types.
+ *
+ * Each record is: type (u8), time since the previous record in the sector
+ * (varint, microseconds), then the payload. Varints are unsigned LEB128;
+ * signed values are zigzag encoded first.
+ */
+typedef enum {
+    RECORDER_EDGE = 1,   // Payload: captured edge word as varint (width << 1 | high)
+    RECORDER_KEY,        // Payload: ir_event_type_t (u8), key (u8)
+    RECORDER_MOTOR,      // Payload: left, right target duty (zigzag varints)
+    RECORDER_BRAKE,      // Payload: brake time in milliseconds (varint)
+    RECORDER_FAILSAFE    // No payload; the failsafe stopped the robot
+} recorder_type_t;
+
+/**
+ * @brief Header at the start of every sector, in RAM and in flash.
+ */
+typedef struct {
+    uint32_t magic;    // RECORDER_MAGIC
+    uint32_t seq;      // Sector sequence number, increasing across reboots
+    uint32_t base_us;  // Time the first record's delta is measured from
+    uint16_t used;     // Bytes in use, header included
+    uint16_t reserved; // Always 0xFFFF
+} recorder_header_t;
+
+/**
+ * @brief Find the reserved flash region and resume after its newest sector.
+ *
+ * Must run on core0 before core1 starts. Records from interrupts that fire
+ * earlier, such as the control tick, are dropped until the first sector is
+ * open. The recorder stays disabled if the program image reaches into the
+ * region.
+ */
+void recorder_init(void);
+
+/**
+ * @brief Record a raw captured IR edge word (see ir_decode_edge()).
+ *
+ * @param edge  The edge word as produced by the capture program.
+ */
+void recorder_edge(uint32_t edge);
+
+/**
+ * @brief Record a key event acted on.
+ *
+ * @param type  The event type (ir_event_type_t).
+ * @param key   The command byte.
+ */
+void recorder_key(uint8_t type, uint8_t key);
+
+/**
+ * @brief Record a new motor target.
+ *
+ * @param left   The left target duty.
+ * @param right  The right target duty.
+ */
+void recorder_motor(int32_t left, int32_t right);
+
+/**
+ * @brief Record a short brake.
+ *
+ * @param brake_ms  The brake time in milliseconds.
+ */
+void recorder_brake(uint32_t brake_ms);
+
+/**
+ * @brief Record the failsafe stopping the robot.
+ */
+void recorder_failsafe(void);
+
+/**
+ * @brief Write staged sectors to flash when it is safe to (core0 only).
+ *
+ * Erasing and programming a sector pauses core1 and masks interrupts on
+ * core0 for tens of milliseconds, so nothing is written unless the caller
+ * says the robot is idle. One sector is written per call.
+ *
+ * @param idle  true if the robot is standing still with no command in flight
+ *              (control_idle()) and nothing is scheduled.
+ */
+void recorder_service(bool idle);
+
+/**
+ * @brief Print every recorded sector, oldest first, then the RAM staging area.
+ *
+ * One line per record with absolute times, e.g. "E 1234567 0000022f" for an
+ * edge word, ready to be replayed through the decoder by tools/ir_replay.c.
+ */
+void recorder_dump(void);
+
+#endif // RECORDER_H
@@ -28,83 +28,359 @@
  */
 
 #include "robot.h"
+#include "ramfunc.h"
 #include "pico/stdlib.h"
 #include "hardware/pwm.h"
 #include "hardware/gpio.h"
+#include "hardware/clocks.h"
+#include "hardware/structs/io_bank0.h"
 
-void setup_pwm(unsigned int pin, uint16_t duty) {
-    // Configure the GPIO pin for PWM function
-    gpio_set_function(pin, GPIO_FUNC_PWM);
+// Counter steps per PWM period at the nominal system clock
+#define MOTOR_PWM_STEPS (SYS_CLK_HZ / MOTOR_PWM_HZ / (MOTOR_PWM_PHASE_CORRECT ? 2 : 1))
+
+// Wrap value, capped at 16 bits (the clock divider covers lower frequencies)
+#define MOTOR_PWM_TOP   (MOTOR_PWM_STEPS > 65536 ? 65535 : MOTOR_PWM_STEPS - 1)
+
+// 16.16 factor mapping a 0-65535 duty onto 0-MOTOR_PWM_TOP
+#define MOTOR_PWM_SCALE ((((uint32_t)MOTOR_PWM_TOP << 16) + 32767) / 65535)
+
+_Static_assert(MOTOR_PWM_TOP >= 255, "MOTOR_PWM_HZ leaves less than 8 bits of duty resolution");
+
+// All four H-bridge direction pins, and those of each motor
+#define MOTOR_DIR_MASK     ((1u << AIN1) | (1u << AIN2) | (1u << BIN1) | (1u << BIN2))
+#define MOTOR_A_MASK       ((1u << AIN1) | (1u << AIN2))
+#define MOTOR_B_MASK       ((1u << BIN1) | (1u << BIN2))
+
+// Direction pin patterns (A = left motor, B = right motor)
+#define MOTOR_DIR_STOP     0u
+#define MOTOR_DIR_BRAKE    MOTOR_DIR_MASK
+
+// Compensation tables have 33 points 2048 duty steps apart, interpolated in between
+#define MOTOR_COMP_POINTS 32
+#define MOTOR_COMP_SHIFT  11
+
+// Raw (unclamped) compensated duty at table point i: lift to the deadband, then trim
+#define MOTOR_COMP_RAW(i, db, trim) \
+    (((db) + (65535u - (db)) * (i) / MOTOR_COMP_POINTS) * (trim) / 1000u)
+
+// Compensated duty at table point i, clamped to full duty
+#define MOTOR_COMP(i, db, trim) \
+    (MOTOR_COMP_RAW(i, db, trim) > 65535u ? 65535u : MOTOR_COMP_RAW(i, db, trim))
+
+// Whole table for one motor, evaluated by the compiler
+#define MOTOR_COMP_TABLE(db, trim) { \
+    MOTOR_COMP(0, db, trim), MOTOR_COMP(1, db, trim), MOTOR_COMP(2, db, trim), MOTOR_COMP(3, db, trim), \
+    MOTOR_COMP(4, db, trim), MOTOR_COMP(5, db, trim), MOTOR_COMP(6, db, trim), MOTOR_COMP(7, db, trim), \
+    MOTOR_COMP(8, db, trim), MOTOR_COMP(9, db, trim), MOTOR_COMP(10, db, trim), MOTOR_COMP(11, db, trim), \
+    MOTOR_COMP(12, db, trim), MOTOR_COMP(13, db, trim), MOTOR_COMP(14, db, trim), MOTOR_COMP(15, db, trim), \
+    MOTOR_COMP(16, db, trim), MOTOR_COMP(17, db, trim), MOTOR_COMP(18, db, trim), MOTOR_COMP(19, db, trim), \
+    MOTOR_COMP(20, db, trim), MOTOR_COMP(21, db, trim), MOTOR_COMP(22, db, trim), MOTOR_COMP(23, db, trim), \
+    MOTOR_COMP(24, db, trim), MOTOR_COMP(25, db, trim), MOTOR_COMP(26, db, trim), MOTOR_COMP(27, db, trim), \
+    MOTOR_COMP(28, db, trim), MOTOR_COMP(29, db, trim), MOTOR_COMP(30, db, trim), MOTOR_COMP(31, db, trim), \
+    MOTOR_COMP(32, db, trim) \
+}
+
+// Duty compensation of each motor, indexed by duty >> MOTOR_COMP_SHIFT
+static const uint16_t motor_comp_a[MOTOR_COMP_POINTS + 1] = MOTOR_COMP_TABLE(MOTOR_A_DEADBAND, MOTOR_A_TRIM);
+static const uint16_t motor_comp_b[MOTOR_COMP_POINTS + 1] = MOTOR_COMP_TABLE(MOTOR_B_DEADBAND, MOTOR_B_TRIM);
+
+// Current decay mode
+static motor_decay_t motor_decay = MOTOR_DECAY_SLOW;
+
+// Pin carrying each motor's PWM duty (PWMx in slow decay, the active INx in fast decay), -1 if none
+static int motor_pin_a = -1;
+static int motor_pin_b = -1;
+
+// Last values written to the hardware
+static uint32_t motor_dir;
+static uint32_t motor_in_pwm;
+static uint16_t motor_duty_a;
+static uint16_t motor_duty_b;
+
+/**
+ * @brief Write the PWM compare level of a pin.
+ *
+ * @param pin   The GPIO pin whose PWM channel to set.
+ * @param duty  The duty cycle (0-65535) to set, rescaled to 0-MOTOR_PWM_TOP.
+ */
+static inline void motor_write_level(uint pin, uint16_t duty) {
+    uint16_t level = (uint16_t)(((uint32_t)duty * MOTOR_PWM_SCALE + 32768) >> 16);
+    pwm_set_chan_level(pwm_gpio_to_slice_num(pin), pwm_gpio_to_channel(pin), level);
+}
+
+/**
+ * @brief Write a PWM level for motor A only if it differs from the cached one.
+ *
+ * @param duty  The duty cycle (0-65535) to set.
+ */
+static inline void motor_set_duty_a(uint16_t duty) {
+    if (duty == motor_duty_a) return;
+    if (motor_pin_a >= 0) motor_write_level(motor_pin_a, duty);
+    motor_duty_a = duty;
+}
+
+/**
+ * @brief Write a PWM level for motor B only if it differs from the cached one.
+ *
+ * @param duty  The duty cycle (0-65535) to set.
+ */
+static inline void motor_set_duty_b(uint16_t duty) {
+    if (duty == motor_duty_b) return;
+    if (motor_pin_b >= 0) motor_write_level(motor_pin_b, duty);
+    motor_duty_b = duty;
+}
+
+/**
+ * @brief Find the single active input pin of one motor.
+ *
+ * @param dir   The direction pin pattern.
+ * @param mask  The input pins of the motor (MOTOR_A_MASK or MOTOR_B_MASK).
+ * @return int  The pin driving the motor, or -1 when coasting or braking.
+ */
+static inline int motor_active_pin(uint32_t dir, uint32_t mask) {
+    uint32_t pins = dir & mask;
+    if (pins == 0 || pins == mask) return -1;
+    return __builtin_ctz(pins);
+}
+
+/**
+ * @brief Select a pin's function without leaving the hot path.
+ *
+ * gpio_set_function() lives in flash; this writes only the FUNCSEL field of
+ * the pin's IO control register, inline. The pad setup it skips was done by
+ * motor_init().
+ *
+ * @param pin  The pin.
+ * @param fn   The function.
+ */
+static inline void motor_set_function(uint pin, gpio_function_t fn) {
+    hw_write_masked(&io_bank0_hw->io[pin].ctrl, (uint32_t)fn << IO_BANK0_GPIO0_CTRL_FUNCSEL_LSB,
+                    IO_BANK0_GPIO0_CTRL_FUNCSEL_BITS);
+}
+
+/**
+ * @brief Switch the input pins for fast decay.
+ *
+ * The active input of each driving motor is handed to its PWM channel so the
+ * off-time coasts (IN1 = IN2 = L). Inputs of coasting or braking motors stay
+ * under SIO control with the levels given in dir.
+ *
+ * @param dir  The direction pin pattern.
+ */
+static void RAM_FUNC(motor_route_fast)(uint32_t dir) {
+    // Active pins get PWM, everything else is a plain output
+    int pin_a = motor_active_pin(dir, MOTOR_A_MASK);
+    int pin_b = motor_active_pin(dir, MOTOR_B_MASK);
+    uint32_t pwm = (pin_a >= 0 ? 1u << pin_a : 0) | (pin_b >= 0 ? 1u << pin_b : 0);
     
-    // Get the PWM slice number for this GPIO pin
-    uint slice_num = pwm_gpio_to_slice_num(pin);
+    // Pins leaving PWM control return to SIO at their new level
+    gpio_put_masked(MOTOR_DIR_MASK, dir & ~pwm);
+    for (uint32_t m = motor_in_pwm & ~pwm; m; m &= m - 1)
+        motor_set_function(__builtin_ctz(m), GPIO_FUNC_SIO);
     
-    // Set PWM wrap value to maximum (16-bit)
-    pwm_set_wrap(slice_num, 65535);
+    // Pins entering PWM control start with no drive
+    for (uint32_t m = pwm & ~motor_in_pwm; m; m &= m - 1) {
+        motor_write_level(__builtin_ctz(m), 0);
+        motor_set_function(__builtin_ctz(m), GPIO_FUNC_PWM);
+    }
     
-    // Set the duty cycle level for this channel
-    pwm_set_chan_level(slice_num, pwm_gpio_to_channel(pin), duty);
+    motor_in_pwm = pwm;
+    motor_pin_a = pin_a;
+    motor_pin_b = pin_b;
+}
+
+/**
+ * @brief Apply a direction pattern and duty cycles with the fewest writes.
+ *
+ * When the direction changes, both duties are dropped to 0 first, then the
+ * direction pins are switched (all four with a single masked SIO write in slow
+ * decay), and only then is the new duty applied. The H-bridge therefore never
+ * drives a motor while its inputs are in a mixed state.
+ *
+ * @param dir     The direction pin pattern (MOTOR_DIR_*).
+ * @param duty_a  The duty cycle (0-65535) for motor A.
+ * @param duty_b  The duty cycle (0-65535) for motor B.
+ */
+static void RAM_FUNC(motor_apply)(uint32_t dir, uint16_t duty_a, uint16_t duty_b) {
+    if (dir != motor_dir) {
+        // Remove drive before the direction pins move
+        motor_set_duty_a(0);
+        motor_set_duty_b(0);
+        
+        // Switch the direction pins
+        if (motor_decay == MOTOR_DECAY_FAST)
+            motor_route_fast(dir);
+        else
+            gpio_put_masked(MOTOR_DIR_MASK, dir);
+        motor_dir = dir;
+    }
     
-    // Enable the PWM slice
-    pwm_set_enabled(slice_num, true);
+    // Write only the duty levels that changed
+    motor_set_duty_a(duty_a);
+    motor_set_duty_b(duty_b);
 }
 
-void motor_stop(void) {
-    // Set both motors to 0% duty cycle
-    setup_pwm(PWMA, 0);
-    setup_pwm(PWMB, 0);
+void motor_init(void) {
+    // Initialize motor direction pins as outputs, driven low
+    gpio_init_mask(MOTOR_DIR_MASK);
+    gpio_put_masked(MOTOR_DIR_MASK, MOTOR_DIR_STOP);
+    gpio_set_dir_out_masked(MOTOR_DIR_MASK);
+    motor_dir = MOTOR_DIR_STOP;
+    motor_in_pwm = 0;
+    
+    // Prepare PWMA/PWMB as outputs too, used as a constant high level in fast decay
+    gpio_init(PWMA);
+    gpio_init(PWMB);
+    gpio_put(PWMA, 1);
+    gpio_put(PWMB, 1);
+    gpio_set_dir(PWMA, GPIO_OUT);
+    gpio_set_dir(PWMB, GPIO_OUT);
+    
+    // Divide the actual system clock down so one period lasts 1/MOTOR_PWM_HZ
+    float period = (float)(MOTOR_PWM_TOP + 1) * (MOTOR_PWM_PHASE_CORRECT ? 2 : 1);
+    float div = (float)clock_get_hz(clk_sys) / ((float)MOTOR_PWM_HZ * period);
+    if (div < 1.0f) div = 1.0f;
     
-    // Disable all H-bridge control pins
-    gpio_put(AIN2, 0);
-    gpio_put(AIN1, 0);
-    gpio_put(BIN2, 0);
-    gpio_put(BIN1, 0);
+    // Set PWM wrap, divider and mode with 0% duty cycle on every motor pin;
+    // slices 0-2 cover PWMA/AIN2, AIN1/BIN1 and BIN2/PWMB
+    const uint pins[] = { PWMA, AIN2, AIN1, BIN1, BIN2, PWMB };
+    for (unsigned int i = 0; i < count_of(pins); i++) {
+        uint slice = pwm_gpio_to_slice_num(pins[i]);
+        pwm_set_wrap(slice, MOTOR_PWM_TOP);
+        pwm_set_clkdiv(slice, div);
+        pwm_set_phase_correct(slice, MOTOR_PWM_PHASE_CORRECT);
+        motor_write_level(pins[i], 0);
+    }
+    motor_duty_a = 0;
+    motor_duty_b = 0;
+    
+    // Enable the PWM slices
+    pwm_set_enabled(pwm_gpio_to_slice_num(PWMA), true);
+    pwm_set_enabled(pwm_gpio_to_slice_num(AIN1), true);
+    pwm_set_enabled(pwm_gpio_to_slice_num(PWMB), true);
+    
+    // Start in slow decay with PWMA/PWMB carrying the duty
+    gpio_set_function(PWMA, GPIO_FUNC_PWM);
+    gpio_set_function(PWMB, GPIO_FUNC_PWM);
+    motor_decay = MOTOR_DECAY_SLOW;
+    motor_pin_a = PWMA;
+    motor_pin_b = PWMB;
+    
+    // Then switch to the configured decay mode, if not slow
+    motor_set_decay(MOTOR_DECAY_DEFAULT);
 }
 
-void motor_forward(uint16_t speed) {
-    // Set motor speeds
-    setup_pwm(PWMA, speed);
-    setup_pwm(PWMB, speed);
+void motor_set_decay(motor_decay_t decay) {
+    if (decay == motor_decay) return;
+    
+    // Coast while the pins are rerouted
+    motor_apply(MOTOR_DIR_STOP, 0, 0);
     
-    // Configure H-bridge for forward direction (both motors forward)
-    gpio_put(AIN2, 1);
-    gpio_put(AIN1, 0);
-    gpio_put(BIN2, 1);
-    gpio_put(BIN1, 0);
+    if (decay == MOTOR_DECAY_FAST) {
+        // PWMA/PWMB held high, the inputs carry the duty once a direction is set
+        gpio_set_function(PWMA, GPIO_FUNC_SIO);
+        gpio_set_function(PWMB, GPIO_FUNC_SIO);
+        motor_pin_a = -1;
+        motor_pin_b = -1;
+    } else {
+        // PWMA/PWMB carry the duty, the inputs are plain outputs
+        gpio_set_function(PWMA, GPIO_FUNC_PWM);
+        gpio_set_function(PWMB, GPIO_FUNC_PWM);
+        motor_pin_a = PWMA;
+        motor_pin_b = PWMB;
+    }
+    motor_decay = decay;
 }
 
-void motor_backward(uint16_t speed) {
-    // Set motor speeds
-    setup_pwm(PWMA, speed);
-    setup_pwm(PWMB, speed);
+void RAM_FUNC(motor_brake)(void) {
+    // Both inputs high on both motors shorts the windings (short brake)
+    motor_apply(MOTOR_DIR_BRAKE, 0, 0);
+}
+
+/**
+ * @brief Convert a signed duty cycle to a PWM level.
+ *
+ * @param duty  The signed duty cycle.
+ * @return uint16_t  The magnitude, clamped to 65535.
+ */
+static inline uint16_t motor_level(int32_t duty) {
+    if (duty < 0) duty = -duty;
+    return duty > 65535 ? 65535 : (uint16_t)duty;
+}
+
+void RAM_FUNC(motor_set)(int32_t duty_a, int32_t duty_b) {
+    // Pick each motor's direction pins from the sign of its duty (0 = coast)
+    uint32_t dir = 0;
+    if (duty_a > 0) dir |= 1u << AIN2;
+    if (duty_a < 0) dir |= 1u << AIN1;
+    if (duty_b > 0) dir |= 1u << BIN2;
+    if (duty_b < 0) dir |= 1u << BIN1;
     
-    // Configure H-bridge for backward direction (both motors reverse)
-    gpio_put(AIN2, 0);
-    gpio_put(AIN1, 1);
-    gpio_put(BIN2, 0);
-    gpio_put(BIN1, 1);
+    // Apply direction and magnitudes
+    motor_apply(dir, motor_level(duty_a), motor_level(duty_b));
 }
 
-void motor_left(uint16_t speed) {
-    // Set motor speeds
-    setup_pwm(PWMA, speed);
-    setup_pwm(PWMB, speed);
+/**
+ * @brief Look up a compensated duty, interpolating between table points.
+ *
+ * @param table  The motor's compensation table.
+ * @param level  The requested duty magnitude (0-65535).
+ * @return uint16_t  The duty to apply; 0 stays 0 so the motor can coast.
+ */
+static inline uint16_t motor_comp(const uint16_t *table, uint16_t level) {
+    if (level == 0) return 0;
     
-    // Configure H-bridge for left turn (left motor backward, right motor forward)
-    gpio_put(AIN2, 0);
-    gpio_put(AIN1, 1);
-    gpio_put(BIN2, 1);
-    gpio_put(BIN1, 0);
+    // Table point below the duty, and how far past it the duty is
+    uint32_t i = level >> MOTOR_COMP_SHIFT;
+    int32_t frac = level & ((1u << MOTOR_COMP_SHIFT) - 1);
+    return (uint16_t)(table[i] + (((int32_t)table[i + 1] - table[i]) * frac >> MOTOR_COMP_SHIFT));
 }
 
-void motor_right(uint16_t speed) {
-    // Set motor speeds
-    setup_pwm(PWMA, speed);
-    setup_pwm(PWMB, speed);
+void RAM_FUNC(motor_drive)(int32_t left, int32_t right) {
+    // Compensate each magnitude, keep its sign
+    int32_t a = motor_comp(motor_comp_a, motor_level(left));
+    int32_t b = motor_comp(motor_comp_b, motor_level(right));
+    motor_set(left < 0 ? -a : a, right < 0 ? -b : b);
+}
+
+void motor_mix(int32_t throttle, int32_t turn, int32_t *left, int32_t *right) {
+    // Turn adds to one wheel and takes from the other
+    int32_t l = throttle + turn;
+    int32_t r = throttle - turn;
     
-    // Configure H-bridge for right turn (left motor forward, right motor backward)
-    gpio_put(AIN2, 1);
-    gpio_put(AIN1, 0);
-    gpio_put(BIN2, 0);
-    gpio_put(BIN1, 1);
+    // Scale both by the same factor if either saturates, keeping the arc's radius
+    int32_t peak = l < 0 ? -l : l;
+    if (r > peak) peak = r;
+    if (-r > peak) peak = -r;
+    if (peak > 65535) {
+        l = (int32_t)((int64_t)l * 65535 / peak);
+        r = (int32_t)((int64_t)r * 65535 / peak);
+    }
+    *left = l;
+    *right = r;
+}
+
+void motor_stop(void) {
+    // Set both motors to 0% duty cycle and disable all H-bridge control pins
+    motor_apply(MOTOR_DIR_STOP, 0, 0);
+}
+
+void motor_forward(uint16_t speed) {
+    // Both wheels forward
+    motor_drive(speed, speed);
+}
+
+void motor_backward(uint16_t speed) {
+    // Both wheels backward
+    motor_drive(-(int32_t)speed, -(int32_t)speed);
+}
+
+void motor_left(uint16_t speed) {
+    // Spin in place: left wheel backward, right wheel forward
+    motor_drive(-(int32_t)speed, speed);
+}
+
+void motor_right(uint16_t speed) {
+    // Spin in place: left wheel forward, right wheel backward
+    motor_drive(speed, -(int32_t)speed);
 }
@@ -41,19 +41,117 @@
 #define BIN2   20
 #define PWMB   21
 
+// PWM carrier frequency in Hz (20 kHz is above the audible range)
+#ifndef MOTOR_PWM_HZ
+#define MOTOR_PWM_HZ 20000
+#endif
+
+// Set to 1 for phase-correct (center-aligned) PWM; halves the resolution at the same frequency
+#ifndef MOTOR_PWM_PHASE_CORRECT
+#define MOTOR_PWM_PHASE_CORRECT 0
+#endif
+
+// Smallest duty that makes each motor turn; lower non-zero duties are lifted to it
+#ifndef MOTOR_A_DEADBAND
+#define MOTOR_A_DEADBAND 0
+#endif
+#ifndef MOTOR_B_DEADBAND
+#define MOTOR_B_DEADBAND 0
+#endif
+
+// Per-motor gain in 1/1000 (1000 = none), to make equal duties drive straight
+#ifndef MOTOR_A_TRIM
+#define MOTOR_A_TRIM 1000
+#endif
+#ifndef MOTOR_B_TRIM
+#define MOTOR_B_TRIM 1000
+#endif
+
+/**
+ * @brief How the H-bridge behaves during the PWM off-time.
+ */
+typedef enum {
+    MOTOR_DECAY_SLOW,  // PWMx switches, inputs fixed: off-time brakes (more linear at low duty)
+    MOTOR_DECAY_FAST   // PWMx high, active input switches: off-time coasts
+} motor_decay_t;
+
+// Decay mode motor_init() leaves the driver in
+#ifndef MOTOR_DECAY_DEFAULT
+#define MOTOR_DECAY_DEFAULT MOTOR_DECAY_SLOW
+#endif
+
+/**
+ * @brief Configure the motor driver pins once at startup.
+ *
+ * Sets the four H-bridge direction pins as outputs, configures every PWM
+ * slice used by the motor pins for MOTOR_PWM_HZ with 0 duty and puts PWMA and
+ * PWMB under PWM control in slow decay, then switches to MOTOR_DECAY_DEFAULT,
+ * leaving the motors stopped. Duty
+ * values passed to the motor functions stay 0-65535 and are rescaled to the
+ * resolution the chosen frequency allows. The motor functions below only touch the registers whose
+ * value actually changes.
+ */
+void motor_init(void);
+
+/**
+ * @brief Select the decay mode used by all motor functions.
+ *
+ * The motors coast while the pins are rerouted, so the next motor command
+ * starts from a stop.
+ *
+ * @param decay  The decay mode to use.
+ */
+void motor_set_decay(motor_decay_t decay);
+
+/**
+ * @brief Short-brake both motors by driving all four H-bridge inputs high.
+ *
+ * Stops far quicker than motor_stop(), which lets the motors coast. The brake
+ * holds until the next motor command.
+ */
+void motor_brake(void);
+
+/**
+ * @brief Drive each motor with its own signed duty cycle, uncompensated.
+ *
+ * Positive values drive the motor forward, negative values backward and 0
+ * lets it coast. Magnitudes above 65535 are clamped.
+ *
+ * @param duty_a  The duty cycle (-65535 to 65535) for motor A (left).
+ * @param duty_b  The duty cycle (-65535 to 65535) for motor B (right).
+ */
+void motor_set(int32_t duty_a, int32_t duty_b);
+
+/**
+ * @brief Drive each wheel with its own signed duty (tank drive).
+ *
+ * Like motor_set(), but each non-zero duty first goes through its motor's
+ * compensation table, built at compile time from MOTOR_x_DEADBAND and
+ * MOTOR_x_TRIM, so both wheels respond alike down to the lowest duties.
+ *
+ * @param left   The duty cycle (-65535 to 65535) for the left wheel.
+ * @param right  The duty cycle (-65535 to 65535) for the right wheel.
+ */
+void motor_drive(int32_t left, int32_t right);
+
 /**
- * @brief Set up PWM on a given pin with a specified duty cycle.
+ * @brief Mix a throttle and a turn rate into wheel duties (arcade drive).
  *
- * Configures the specified GPIO pin for PWM output, sets the PWM wrap value,
- * sets the channel level (duty cycle), and enables the PWM slice.
+ * The turn is added to the left wheel and taken from the right. If either
+ * wheel would exceed full duty, both are scaled down together so the arc
+ * keeps its shape.
  *
- * @param pin   The GPIO pin number to configure for PWM.
- * @param duty  The duty cycle (0-65535) to set for the PWM channel.
+ * @param throttle  Forward duty (-65535 to 65535), negative is backward.
+ * @param turn      Turn duty (-65535 to 65535), positive turns right.
+ * @param left      Receives the left wheel duty.
+ * @param right     Receives the right wheel duty.
  */
-void setup_pwm(unsigned int pin, uint16_t duty);
+void motor_mix(int32_t throttle, int32_t turn, int32_t *left, int32_t *right);
 
 /**
  * @brief Stop both motors by setting PWM duty to 0 and disabling H-bridge outputs.
+ *
+ * The motors coast to a stop; use motor_brake() to stop actively.
  */
 void motor_stop(void);
 
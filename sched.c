@@ -0,0 +1,116 @@
+/**
+ * @file sched.c
+ * @brief Cooperative scheduler with static tasks, timer wakeups and deadline accounting
+ * @author Kevin Thomas
+ * @date 2025
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Kevin Thomas
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include "sched.h"
+#include "ramfunc.h"
+
+void sched_init(sched_t *s, sched_task_t *tasks, uint32_t count, uint32_t (*now_us)(void)) {
+    s->tasks = tasks;
+    s->count = count;
+    s->now_us = now_us;
+    
+    // Clear the counters and release every task now
+    uint32_t now = now_us();
+    for (uint32_t i = 0; i < count; i++) {
+        sched_task_t *t = &tasks[i];
+        t->release_us = now;
+        t->runs = 0;
+        t->misses = 0;
+        t->max_us = 0;
+        t->max_late_us = 0;
+        t->total_us = 0;
+    }
+}
+
+void RAM_FUNC(sched_release)(sched_task_t *t, uint32_t now_us) {
+    // The next pass runs it; lateness is measured from now
+    t->release_us = now_us;
+}
+
+void RAM_FUNC(sched_account)(sched_task_t *t, uint32_t release_us, uint32_t start_us, uint32_t end_us) {
+    // Run time, lateness and whether the deadline held
+    uint32_t run_us = end_us - start_us;
+    uint32_t late_us = start_us - release_us;
+    t->runs++;
+    t->total_us += run_us;
+    if (run_us > t->max_us) t->max_us = run_us;
+    if ((int32_t)late_us > 0 && late_us > t->max_late_us) t->max_late_us = late_us;
+    if ((int32_t)(end_us - release_us) > (int32_t)t->deadline_us) t->misses++;
+}
+
+uint32_t RAM_FUNC(sched_run)(sched_t *s) {
+    uint32_t pass_us = s->now_us();
+    
+    for (uint32_t i = 0; i < s->count; i++) {
+        sched_task_t *t = &s->tasks[i];
+        uint32_t start_us = s->now_us();
+        
+        // Interrupt-driven entries only collect counters
+        if (!t->run) continue;
+        
+        // Periodic tasks wait for their release; the others are released by this pass
+        if (t->period_us == 0) t->release_us = pass_us;
+        else if ((int32_t)(start_us - t->release_us) < 0) continue;
+        
+        t->run();
+        uint32_t end_us = s->now_us();
+        sched_account(t, t->release_us, start_us, end_us);
+        
+        // Next release on the period grid, skipping any already missed
+        if (t->period_us) {
+            t->release_us += t->period_us;
+            if ((int32_t)(end_us - t->release_us) >= 0) t->release_us = end_us + t->period_us;
+        }
+    }
+    
+    // Earliest periodic release, or now if no task is periodic
+    uint32_t now = s->now_us();
+    uint32_t wake_us = 0;
+    bool found = false;
+    for (uint32_t i = 0; i < s->count; i++) {
+        const sched_task_t *t = &s->tasks[i];
+        if (t->run && t->period_us && (!found || (int32_t)(t->release_us - wake_us) < 0)) {
+            wake_us = t->release_us;
+            found = true;
+        }
+    }
+    return found ? wake_us : now;
+}
+
+void sched_print(const sched_t *s) {
+    // One row per task: runs, mean and worst run time, worst lateness, misses
+    printf("%-10s %10s %8s %8s %8s %8s\n", "task", "runs", "avg us", "max us", "late us", "misses");
+    for (uint32_t i = 0; i < s->count; i++) {
+        const sched_task_t *t = &s->tasks[i];
+        printf("%-10s %10lu %8lu %8lu %8lu %8lu\n", t->name, (unsigned long)t->runs,
+               (unsigned long)(t->runs ? t->total_us / t->runs : 0), (unsigned long)t->max_us,
+               (unsigned long)t->max_late_us, (unsigned long)t->misses);
+    }
+}
@@ -0,0 +1,121 @@
+/**
+ * @file sched.h
+ * @brief Cooperative scheduler with static tasks, timer wakeups and deadline accounting
+ * @author Kevin Thomas
+ * @date 2025
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Kevin Thomas
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SCHED_H
+#define SCHED_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief A statically allocated task and its counters.
+ *
+ * Set name, run, period_us and deadline_us; sched_init() clears the rest.
+ */
+typedef struct {
+    const char *name;      // Name printed by sched_print()
+    void (*run)(void);     // Task body, must not block; NULL for work done in an interrupt
+    uint32_t period_us;    // Release interval, or 0 to run on every pass
+    uint32_t deadline_us;  // A run finishing later than this after its release is a miss
+    uint32_t release_us;   // Time of the next (or, for period 0, the current) release
+    uint32_t runs;         // Completed runs
+    uint32_t misses;       // Runs that finished past their deadline
+    uint32_t max_us;       // Longest run time
+    uint32_t max_late_us;  // Longest delay from release to start
+    uint64_t total_us;     // Run time summed over all runs
+} sched_task_t;
+
+/**
+ * @brief A scheduler instance: a fixed task table and the clock it runs on.
+ *
+ * The clock is a plain function, so the same scheduler runs on the robot with
+ * time_us_32() and on a host with a virtual clock the test advances.
+ */
+typedef struct {
+    sched_task_t *tasks;       // Task table, in priority order
+    uint32_t count;            // Number of tasks
+    uint32_t (*now_us)(void);  // Microsecond clock
+} sched_t;
+
+/**
+ * @brief Set up a scheduler; every periodic task is released at once.
+ *
+ * @param s       The scheduler.
+ * @param tasks   The task table, highest priority first.
+ * @param count   The number of tasks.
+ * @param now_us  The microsecond clock.
+ */
+void sched_init(sched_t *s, sched_task_t *tasks, uint32_t count, uint32_t (*now_us)(void));
+
+/**
+ * @brief Run every due task once, in table order.
+ *
+ * Tasks are never preempted by each other, so a long run delays the tasks
+ * after it and shows up in their lateness and deadline misses. A periodic
+ * task that falls a whole period behind skips the releases it missed.
+ *
+ * @param s  The scheduler.
+ * @return uint32_t  The time the next periodic task is due, or now if none
+ *                   is; tasks with period 0 need an external wake-up.
+ */
+uint32_t sched_run(sched_t *s);
+
+/**
+ * @brief Release a periodic task now instead of at its next grid time.
+ *
+ * For work that an interrupt or wake-up makes due early, such as IR edges
+ * arriving while the core slept. Later releases follow the period from now.
+ *
+ * @param t       The task to release.
+ * @param now_us  The current time.
+ */
+void sched_release(sched_task_t *t, uint32_t now_us);
+
+/**
+ * @brief Add one run of work done outside sched_run() to a task's counters.
+ *
+ * Lets interrupt-driven work, such as the control tick, report in the same
+ * table as the cooperative tasks. Give such an entry a NULL run function so
+ * sched_run() leaves it alone.
+ *
+ * @param t           The task to charge.
+ * @param release_us  The time the run was due.
+ * @param start_us    The time the run started.
+ * @param end_us      The time the run finished.
+ */
+void sched_account(sched_task_t *t, uint32_t release_us, uint32_t start_us, uint32_t end_us);
+
+/**
+ * @brief Print one line of counters per task.
+ *
+ * @param s  The scheduler.
+ */
+void sched_print(const sched_t *s);
+
+#endif // SCHED_H
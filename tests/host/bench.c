@@ -0,0 +1,300 @@
+/**
+ * @file bench.c
+ * @brief Host bench: IR decode rates through the capture path and motor API cost per command
+ * @author Kevin Thomas
+ * @date 2025
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Kevin Thomas
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "pico.h"
+#include "fake_sdk.h"
+#include "ir_wave.h"
+#include "ir.h"
+#include "robot.h"
+#include "control.h"
+
+// Frames sent per scenario unless given on the command line
+#define BENCH_FRAMES 500
+
+// How often core1 polls the capture ring
+#define BENCH_POLL_US 1000
+
+// Idle time after each frame, as between presses on a real remote
+#define BENCH_IDLE_US 40000
+
+// Most frames one slot sends or decodes
+#define BENCH_SLOT_FRAMES 8
+
+// Settling time given to the control tick after each motor command
+#define BENCH_SETTLE_US 300000
+
+/**
+ * @brief Results of one scenario.
+ */
+typedef struct {
+    uint32_t sent;           // Frames sent
+    uint32_t accepted;       // Frames decoded as sent
+    uint32_t false_accept;   // Frames decoded that were not sent
+    uint32_t false_reject;   // Frames sent that were not decoded
+    uint32_t edges;          // Pulses played
+    uint64_t signal_us;      // Waveform time
+    double cpu_s;            // Host time spent in ir_poll()
+} bench_result_t;
+
+/**
+ * @brief A scenario: fills one slot's waveform and the frames it should decode to.
+ */
+typedef struct {
+    const char *name;
+    ir_wave_impair_t impair;
+    double max_reject_pct;   // Most frames --check lets the scenario lose
+    uint32_t (*build)(ir_wave_t *w, uint32_t k, ir_frame_t *expect);
+} bench_scenario_t;
+
+// Pulse storage for one slot
+static fake_pulse_t bench_pulses[4096];
+
+/**
+ * @brief Build a standard NEC frame with a pseudo-random address and command.
+ */
+static uint32_t bench_nec(ir_wave_t *w, uint32_t k, ir_frame_t *expect) {
+    uint8_t address = (uint8_t)ir_wave_random(w, 256), command = (uint8_t)ir_wave_random(w, 256);
+    (void)k;
+    ir_wave_nec(w, address, command);
+    expect[0] = (ir_frame_t){ IR_PROTOCOL_NEC, address, command, false };
+    return 1;
+}
+
+/**
+ * @brief Build an NEC frame from a remote whose clock drifts from frame to frame.
+ */
+static uint32_t bench_drift(ir_wave_t *w, uint32_t k, ir_frame_t *expect) {
+    w->impair.clock_scale = 1.0 + ((int)(k % 3) - 1) * 0.1;
+    return bench_nec(w, k, expect);
+}
+
+/**
+ * @brief Build a noise burst, then an NEC frame.
+ */
+static uint32_t bench_noisy(ir_wave_t *w, uint32_t k, ir_frame_t *expect) {
+    ir_wave_noise(w, 30000);
+    ir_wave_idle(w, 10000);
+    return bench_nec(w, k, expect);
+}
+
+/**
+ * @brief Build an NEC frame followed by three repeat codes at the 108ms NEC period.
+ */
+static uint32_t bench_repeat(ir_wave_t *w, uint32_t k, ir_frame_t *expect) {
+    uint32_t n = bench_nec(w, k, expect);
+    for (int i = 0; i < 3; i++) {
+        ir_wave_idle(w, 108000 - (uint32_t)(w->duration_us % 108000));
+        ir_wave_nec_repeat(w);
+        expect[n] = expect[0];
+        expect[n++].repeat = true;
+    }
+    return n;
+}
+
+/**
+ * @brief Build one frame of every protocol variant in turn.
+ */
+static uint32_t bench_mixed(ir_wave_t *w, uint32_t k, ir_frame_t *expect) {
+    uint8_t command = (uint8_t)ir_wave_random(w, 128);
+    switch (k % 6) {
+        case 0:
+            return bench_nec(w, k, expect);
+        case 1:
+            ir_wave_nec_ext(w, 0x1234, command);
+            expect[0] = (ir_frame_t){ IR_PROTOCOL_NEC_EXT, 0x1234, command, false };
+            return 1;
+        case 2: // Toggle flips on every RC5 frame, so none is a repeat
+        case 3:
+            ir_wave_rc5(w, 0x15, k % 6 == 2 ? command & 0x3F : command | 0x40, (k / 6 + k) & 1);
+            expect[0] = (ir_frame_t){ IR_PROTOCOL_RC5, 0x15, k % 6 == 2 ? command & 0x3F : command | 0x40, false };
+            return 1;
+        case 4:
+            ir_wave_sirc(w, command, 0x01, 12);
+            expect[0] = (ir_frame_t){ IR_PROTOCOL_SIRC, 0x01, command, false };
+            return 1;
+        default:
+            ir_wave_sirc(w, command, 0x1A5, 20);
+            expect[0] = (ir_frame_t){ IR_PROTOCOL_SIRC, 0x1A5, command, false };
+            return 1;
+    }
+}
+
+// Scenarios run, in order
+static const bench_scenario_t bench_scenarios[] = {
+    { "clean",  { 1.0, 0, 0, 1 },     0,  bench_nec },
+    { "jitter", { 1.0, 60, 0, 2 },    0,  bench_drift },
+    { "noise",  { 1.0, 20, 0.02, 3 }, 5,  bench_noisy },
+    { "repeat", { 1.0, 20, 0, 4 },    0,  bench_repeat },
+    { "mixed",  { 1.0, 20, 0, 5 },    0,  bench_mixed },
+};
+
+/**
+ * @brief Check a decoded frame against the one expected.
+ */
+static bool bench_same(const ir_frame_t *a, const ir_frame_t *b) {
+    return a->protocol == b->protocol && a->address == b->address &&
+           a->command == b->command && a->repeat == b->repeat;
+}
+
+/**
+ * @brief Send a scenario's frames through the fake receiver and ir_poll().
+ *
+ * @param sc      The scenario.
+ * @param frames  Number of slots to send.
+ * @return bench_result_t  The counts.
+ */
+static bench_result_t bench_ir(const bench_scenario_t *sc, uint32_t frames) {
+    bench_result_t r = { 0 };
+    ir_wave_t w;
+    ir_wave_init(&w, bench_pulses, count_of(bench_pulses), &sc->impair);
+    
+    for (uint32_t k = 0; k < frames; k++) {
+        // One slot: the scenario's frames, then idle
+        ir_frame_t expect[BENCH_SLOT_FRAMES];
+        uint32_t rng = w.rng;
+        ir_wave_init(&w, bench_pulses, count_of(bench_pulses), &sc->impair);
+        w.rng = rng;
+        uint32_t expected = sc->build(&w, k, expect);
+        ir_wave_idle(&w, BENCH_IDLE_US);
+        r.sent += expected;
+        r.edges += (uint32_t)w.count;
+        r.signal_us += w.duration_us;
+        
+        // Play it and poll at the core1 task rate
+        uint32_t next = 0;
+        uint64_t end = fake_now_us() + w.duration_us;
+        fake_ir_play(w.pulses, w.count);
+        clock_t start = clock();
+        while (fake_now_us() < end) {
+            fake_advance_us(BENCH_POLL_US);
+            ir_frame_t f;
+            while (ir_poll(&f)) {
+                if (next < expected && bench_same(&f, &expect[next])) {
+                    r.accepted++;
+                    next++;
+                } else {
+                    r.false_accept++;
+                }
+            }
+        }
+        r.cpu_s += (double)(clock() - start) / CLOCKS_PER_SEC;
+        r.false_reject += expected - next;
+    }
+    return r;
+}
+
+/**
+ * @brief A remote key and what it does.
+ */
+typedef struct {
+    const char *name;
+    int key;
+} bench_command_t;
+
+// Commands timed, in order; "forward" twice shows the cost of a repeated command
+static const bench_command_t bench_commands[] = {
+    { "forward", 0x18 },
+    { "forward", 0x18 },
+    { "speed+",  0x15 },
+    { "forward", 0x18 },
+    { "left",    0x08 },
+    { "right",   0x5A },
+    { "backward", 0x52 },
+    { "stop",    0x1C },
+};
+
+/**
+ * @brief Print the SDK calls each remote command causes until the motors settle.
+ */
+static void bench_motor(void) {
+    uint16_t speed = 32768;
+    motor_init();
+    control_init(NULL);
+    fake_advance_us(BENCH_SETTLE_US);
+    
+    printf("\n%-10s %10s %10s %10s %10s\n", "command", "pwm_level", "put_mask", "set_func", "per_tick");
+    for (size_t i = 0; i < count_of(bench_commands); i++) {
+        fake_clear_writes();
+        process_ir_command(bench_commands[i].key, &speed);
+        fake_advance_us(BENCH_SETTLE_US);
+        uint32_t total = fake_calls.pwm_set_chan_level + fake_calls.gpio_put_masked +
+                         fake_calls.gpio_set_function + fake_calls.gpio_put;
+        printf("%-10s %10lu %10lu %10lu %10.3f\n", bench_commands[i].name,
+               (unsigned long)fake_calls.pwm_set_chan_level, (unsigned long)fake_calls.gpio_put_masked,
+               (unsigned long)fake_calls.gpio_set_function,
+               (double)total * CONTROL_TICK_US / BENCH_SETTLE_US);
+    }
+}
+
+/**
+ * @brief Run the bench.
+ *
+ * Usage: bench [frames] [--check]. With --check the exit status fails when
+ * a scenario invents a frame or drops more than its guard allows.
+ */
+int main(int argc, char **argv) {
+    uint32_t frames = BENCH_FRAMES;
+    bool check = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--check") == 0) check = true;
+        else frames = (uint32_t)strtoul(argv[i], NULL, 0);
+    }
+    
+    fake_reset();
+    ir_init();
+    
+    // IR decode through PIO capture, DMA ring and ir_poll()
+    printf("%-8s %7s %7s %7s %7s %9s %9s %8s %8s\n",
+           "scenario", "sent", "ok", "FA", "FR", "FA%", "FR%", "frames/s", "ns/edge");
+    int failed = 0;
+    for (size_t i = 0; i < count_of(bench_scenarios); i++) {
+        bench_result_t r = bench_ir(&bench_scenarios[i], frames);
+        double fa = 100.0 * r.false_accept / r.sent, fr = 100.0 * r.false_reject / r.sent;
+        printf("%-8s %7lu %7lu %7lu %7lu %8.2f%% %8.2f%% %8.1f %8.1f\n", bench_scenarios[i].name,
+               (unsigned long)r.sent, (unsigned long)r.accepted, (unsigned long)r.false_accept,
+               (unsigned long)r.false_reject, fa, fr, r.accepted * 1e6 / r.signal_us,
+               r.cpu_s * 1e9 / r.edges);
+        
+        // Guards: nothing is ever invented, and only impaired signals may lose frames
+        if (r.false_accept || fr > bench_scenarios[i].max_reject_pct) failed = 1;
+    }
+    
+    // Motor API cost per command
+    bench_motor();
+    
+    if (check && failed) {
+        printf("FAIL\n");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,60 @@
+/**
+ * @file check.h
+ * @brief Minimal assertions for the host tests
+ * @author Kevin Thomas
+ * @date 2025
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Kevin Thomas
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Failures seen so far in this test program
+static int check_failures;
+
+// Report a failed condition and keep going, so one run lists every failure
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        check_failures++; \
+    } \
+} while (0)
+
+// Report two integers that should be equal, with both values
+#define CHECK_EQ(a, b) do { \
+    long long check_a = (long long)(a), check_b = (long long)(b); \
+    if (check_a != check_b) { \
+        fprintf(stderr, "%s:%d: check failed: %s == %s (%lld != %lld)\n", \
+                __FILE__, __LINE__, #a, #b, check_a, check_b); \
+        check_failures++; \
+    } \
+} while (0)
+
+// Exit status for main(): print a summary and fail if any check did
+#define CHECK_DONE() (printf("%s\n", check_failures ? "FAIL" : "PASS"), check_failures ? EXIT_FAILURE : EXIT_SUCCESS)
+
+#endif // CHECK_H
@@ -0,0 +1,822 @@
+/**
+ * @file fake_sdk.c
+ * @brief Virtual clock, pin model and call counters behind the host build's fake pico SDK
+ * @author Kevin Thomas
+ * @date 2025
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Kevin Thomas
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <string.h>
+#include "fake_sdk.h"
+#include "ir.h"
+#include "pico/time.h"
+#include "pico/stdio.h"
+#include "pico/stdio_usb.h"
+#include "pico/flash.h"
+#include "hardware/gpio.h"
+#include "hardware/pwm.h"
+#include "hardware/clocks.h"
+#include "hardware/sync.h"
+#include "hardware/pio.h"
+#include "hardware/dma.h"
+#include "hardware/flash.h"
+#include "hardware/structs/io_bank0.h"
+#include "tusb.h"
+
+// Alarms that can be pending at once
+#define FAKE_ALARMS 16
+
+// PWM slices and channels modelled
+#define FAKE_PWM_SLICES 12
+
+/**
+ * @brief One pending one-shot alarm.
+ */
+typedef struct {
+    alarm_id_t id;              // 0 when the slot is free
+    uint64_t due_us;            // Time the callback runs
+    alarm_callback_t callback;  // Called once due
+    void *user_data;            // Passed through to the callback
+} fake_alarm_t;
+
+fake_calls_t fake_calls;
+fake_write_t fake_log[FAKE_LOG_SIZE];
+uint32_t fake_log_count;
+
+pio_hw_t fake_pio0_hw;
+uint8_t fake_flash[PICO_FLASH_SIZE_BYTES];
+
+// The program image takes no flash on a host, so it ends where flash starts
+extern char __flash_binary_end __attribute__((alias("fake_flash")));
+
+// Virtual clock, and how far each read moves it
+static uint64_t fake_time_us;
+static uint32_t fake_time_step_us;
+
+// Set while fake_advance_us() runs callbacks, so clock reads inside them stay put
+static bool fake_in_advance;
+
+// Event register: set by __sev() and by every interrupt, consumed by WFE
+static bool fake_event;
+
+// IO bank 0 registers; the FUNCSEL field of each ctrl is the pin's function
+io_bank0_hw_t fake_io_bank0;
+
+// Pin state
+static uint64_t fake_gpio_out_bits;
+static gpio_irq_callback_t fake_gpio_irq_callback;
+static uint32_t fake_gpio_irq_mask;
+
+// PWM state
+static uint16_t fake_pwm_levels[FAKE_PWM_SLICES * 2];
+static uint16_t fake_pwm_wraps[FAKE_PWM_SLICES];
+
+// Timers
+static fake_alarm_t fake_alarms[FAKE_ALARMS];
+static alarm_id_t fake_alarm_next_id;
+static repeating_timer_t *fake_timers;
+
+// IR waveform being played and the level on the pin
+static const fake_pulse_t *fake_ir_pulses;
+static size_t fake_ir_count;
+static size_t fake_ir_index;
+static uint64_t fake_ir_pulse_end_us;
+static bool fake_ir_level = true;
+
+// Capture state machine: started, synced to the first falling edge, current level start
+static bool fake_capture_on;
+static bool fake_capture_synced;
+static uint64_t fake_capture_start_us;
+
+// DMA ring the capture words land in
+static volatile uint32_t *fake_dma_base;
+static uint32_t fake_dma_words;
+static uint32_t fake_dma_index;
+static dma_channel_hw_t fake_dma_hw;
+
+// USB CDC state
+static bool fake_usb_connected;
+static uint32_t fake_usb_room;
+
+// Bytes waiting to be read from USB, and bytes written to it
+static const uint8_t *fake_usb_in;
+static size_t fake_usb_in_len;
+static uint8_t fake_usb_out[256];
+static size_t fake_usb_out_len;
+
+/**
+ * @brief Append a hardware write to the log.
+ *
+ * @param op  What was written.
+ * @param a   First argument.
+ * @param b   Second argument.
+ */
+static void fake_log_write(fake_op_t op, uint32_t a, uint32_t b) {
+    if (fake_log_count < FAKE_LOG_SIZE)
+        fake_log[fake_log_count] = (fake_write_t){ op, a, b };
+    fake_log_count++;
+}
+
+/**
+ * @brief Store one capture word in the DMA ring, as the DREQ would.
+ *
+ * @param word  The edge word.
+ */
+static void fake_dma_push(uint32_t word) {
+    if (!fake_dma_base || !fake_dma_words) return;
+    fake_dma_base[fake_dma_index] = word;
+    fake_dma_index = (fake_dma_index + 1) % fake_dma_words;
+    fake_dma_hw.write_addr = (uint32_t)(uintptr_t)&fake_dma_base[fake_dma_index];
+}
+
+/**
+ * @brief Change the IR pin level now, feeding the capture and the edge IRQ.
+ *
+ * @param level  The new level.
+ */
+static void fake_ir_set_level(bool level) {
+    if (level == fake_ir_level) return;
+    fake_ir_level = level;
+    uint32_t width = (uint32_t)(fake_time_us - fake_capture_start_us);
+    
+    // The state machine pushes the width of the level that just ended
+    if (fake_capture_on) {
+        if (fake_capture_synced) {
+            fake_dma_push(level ? width : ~width);
+        } else if (!level) {
+            fake_capture_synced = true;
+        }
+    }
+    fake_capture_start_us = fake_time_us;
+    
+    // Edge interrupt, which also wakes a core waiting in WFE
+    uint32_t event = level ? GPIO_IRQ_EDGE_RISE : GPIO_IRQ_EDGE_FALL;
+    if ((fake_gpio_irq_mask & event) && fake_gpio_irq_callback) {
+        fake_gpio_irq_callback(IR_PIN, event);
+        fake_event = true;
+    }
+}
+
+/**
+ * @brief Start the pulse at fake_ir_index, or return to idle after the last.
+ */
+static void fake_ir_start_pulse(void) {
+    if (fake_ir_index >= fake_ir_count) {
+        fake_ir_pulses = NULL;
+        fake_ir_set_level(true);
+        return;
+    }
+    fake_ir_pulse_end_us = fake_time_us + fake_ir_pulses[fake_ir_index].us;
+    fake_ir_set_level(fake_ir_pulses[fake_ir_index].high);
+}
+
+bool fake_next_due(uint64_t *when) {
+    bool found = false;
+    uint64_t next = UINT64_MAX;
+    
+    // Earliest of alarms, repeating timers and the end of the IR pulse
+    for (int i = 0; i < FAKE_ALARMS; i++)
+        if (fake_alarms[i].id && fake_alarms[i].due_us < next) next = fake_alarms[i].due_us, found = true;
+    for (repeating_timer_t *t = fake_timers; t; t = t->next)
+        if (t->due_us < next) next = t->due_us, found = true;
+    if (fake_ir_pulses && fake_ir_pulse_end_us < next) next = fake_ir_pulse_end_us, found = true;
+    
+    if (found) *when = next;
+    return found;
+}
+
+/**
+ * @brief Run everything due at the current time, in a fixed order.
+ */
+static void fake_fire_due(void) {
+    // IR edges first, they are hardware and do not wait for interrupts
+    while (fake_ir_pulses && fake_ir_pulse_end_us <= fake_time_us) {
+        fake_ir_index++;
+        fake_ir_start_pulse();
+    }
+    
+    // One-shot alarms, rescheduled by their return value
+    for (int i = 0; i < FAKE_ALARMS; i++) {
+        fake_alarm_t *a = &fake_alarms[i];
+        if (!a->id || a->due_us > fake_time_us) continue;
+        int64_t ret = a->callback(a->id, a->user_data);
+        fake_event = true;
+        if (ret < 0) a->due_us += (uint64_t)-ret;
+        else if (ret > 0) a->due_us = fake_time_us + (uint64_t)ret;
+        else a->id = 0;
+    }
+    
+    // Repeating timers, unlinked once their callback returns false
+    for (repeating_timer_t **link = &fake_timers; *link;) {
+        repeating_timer_t *t = *link;
+        if (t->due_us > fake_time_us) {
+            link = &t->next;
+            continue;
+        }
+        fake_event = true;
+        if (t->callback(t)) {
+            t->due_us = t->delay_us < 0 ? t->due_us + (uint64_t)-t->delay_us : fake_time_us + (uint64_t)t->delay_us;
+            link = &t->next;
+        } else {
+            t->active = false;
+            *link = t->next;
+        }
+    }
+}
+
+void fake_advance_us(uint64_t us) {
+    uint64_t target = fake_time_us + us;
+    
+    // Step from one due event to the next so callbacks see the right time
+    bool nested = fake_in_advance;
+    fake_in_advance = true;
+    uint64_t when;
+    while (fake_next_due(&when) && when <= target) {
+        if (when > fake_time_us) fake_time_us = when;
+        fake_fire_due();
+    }
+    fake_time_us = target;
+    fake_in_advance = nested;
+}
+
+void fake_reset(void) {
+    // Clock
+    fake_time_us = 0;
+    fake_time_step_us = 0;
+    fake_in_advance = false;
+    fake_event = false;
+    
+    // Pins and PWM
+    fake_gpio_out_bits = 0;
+    for (int i = 0; i < FAKE_GPIO_COUNT; i++) fake_io_bank0.io[i].ctrl = GPIO_FUNC_NULL;
+    fake_gpio_irq_callback = NULL;
+    fake_gpio_irq_mask = 0;
+    memset(fake_pwm_levels, 0, sizeof(fake_pwm_levels));
+    memset(fake_pwm_wraps, 0xFF, sizeof(fake_pwm_wraps));
+    
+    // Timers
+    memset(fake_alarms, 0, sizeof(fake_alarms));
+    fake_alarm_next_id = 0;
+    for (repeating_timer_t *t = fake_timers; t; t = t->next) t->active = false;
+    fake_timers = NULL;
+    
+    // IR, capture and DMA
+    fake_ir_pulses = NULL;
+    fake_ir_count = fake_ir_index = 0;
+    fake_ir_level = true;
+    fake_capture_on = fake_capture_synced = false;
+    fake_capture_start_us = 0;
+    fake_dma_base = NULL;
+    fake_dma_words = fake_dma_index = 0;
+    memset(&fake_dma_hw, 0, sizeof(fake_dma_hw));
+    
+    // USB, flash and counters
+    fake_usb_connected = false;
+    fake_usb_room = 0;
+    fake_usb_in = NULL;
+    fake_usb_in_len = 0;
+    fake_usb_out_len = 0;
+    memset(fake_flash, 0xFF, sizeof(fake_flash));
+    fake_clear_writes();
+}
+
+void fake_clear_writes(void) {
+    memset(&fake_calls, 0, sizeof(fake_calls));
+    fake_log_count = 0;
+}
+
+uint64_t fake_now_us(void) {
+    return fake_time_us;
+}
+
+void fake_set_time_step(uint32_t us) {
+    fake_time_step_us = us;
+}
+
+void fake_ir_play(const fake_pulse_t *pulses, size_t count) {
+    fake_ir_pulses = pulses;
+    fake_ir_count = count;
+    fake_ir_index = 0;
+    fake_ir_start_pulse();
+}
+
+bool fake_ir_done(void) {
+    return fake_ir_pulses == NULL;
+}
+
+uint32_t fake_gpio_function(uint32_t pin) {
+    return pin < FAKE_GPIO_COUNT ? fake_io_bank0.io[pin].ctrl & IO_BANK0_GPIO0_CTRL_FUNCSEL_BITS : GPIO_FUNC_NULL;
+}
+
+bool fake_gpio_out(uint32_t pin) {
+    return pin < FAKE_GPIO_COUNT && ((fake_gpio_out_bits >> pin) & 1u);
+}
+
+uint16_t fake_pwm_level(uint32_t pin) {
+    return fake_pwm_levels[FAKE_PWM_CHAN(pin)];
+}
+
+uint16_t fake_pwm_top(uint32_t pin) {
+    return fake_pwm_wraps[pwm_gpio_to_slice_num(pin)];
+}
+
+void fake_usb_set(bool connected, uint32_t room) {
+    fake_usb_connected = connected;
+    fake_usb_room = room;
+}
+
+void fake_usb_input(const void *data, size_t len) {
+    fake_usb_in = data;
+    fake_usb_in_len = len;
+}
+
+size_t fake_usb_output(uint8_t *buf, size_t max) {
+    // Take everything written since the last call
+    size_t n = fake_usb_out_len < max ? fake_usb_out_len : max;
+    memcpy(buf, fake_usb_out, n);
+    fake_usb_out_len = 0;
+    return n;
+}
+
+// ---------------------------------------------------------------------------
+// pico/time.h
+// ---------------------------------------------------------------------------
+
+uint64_t time_us_64(void) {
+    if (fake_time_step_us && !fake_in_advance) fake_advance_us(fake_time_step_us);
+    return fake_time_us;
+}
+
+uint32_t time_us_32(void) {
+    return (uint32_t)time_us_64();
+}
+
+absolute_time_t get_absolute_time(void) {
+    return time_us_64();
+}
+
+int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to) {
+    return (int64_t)(to - from);
+}
+
+uint64_t to_us_since_boot(absolute_time_t t) {
+    return t;
+}
+
+absolute_time_t make_timeout_time_us(uint64_t us) {
+    return fake_time_us + us;
+}
+
+absolute_time_t make_timeout_time_ms(uint32_t ms) {
+    return fake_time_us + (uint64_t)ms * 1000u;
+}
+
+absolute_time_t delayed_by_us(absolute_time_t t, uint64_t us) {
+    return t + us;
+}
+
+void sleep_us(uint64_t us) {
+    fake_advance_us(us);
+}
+
+void sleep_ms(uint32_t ms) {
+    fake_advance_us((uint64_t)ms * 1000u);
+}
+
+void sleep_until(absolute_time_t t) {
+    if (t > fake_time_us) fake_advance_us(t - fake_time_us);
+}
+
+void busy_wait_us(uint64_t us) {
+    fake_advance_us(us);
+}
+
+/**
+ * @brief Sleep as WFE does: until an event is signalled or the clock reaches a limit.
+ *
+ * Pulse ends with their edge interrupt disabled are not events, so a core
+ * that sleeps without a wake source sleeps until the limit.
+ *
+ * @param until_us  The limit.
+ * @return bool  true if an event ended the wait; the event is consumed.
+ */
+static bool fake_wait_event(uint64_t until_us) {
+    uint64_t when;
+    while (!fake_event && fake_time_us < until_us) {
+        if (!fake_next_due(&when) || when > until_us) when = until_us;
+        fake_advance_us(when > fake_time_us ? when - fake_time_us : 0);
+    }
+    bool woke = fake_event;
+    fake_event = false;
+    return woke;
+}
+
+bool best_effort_wfe_or_timeout(absolute_time_t t) {
+    if (fake_time_us >= t) return true;
+    
+    // Wake on whichever comes first, the timeout or an event
+    fake_wait_event(t);
+    return fake_time_us >= t;
+}
+
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void *user_data, bool fire_if_past) {
+    (void)fire_if_past;
+    for (int i = 0; i < FAKE_ALARMS; i++) {
+        if (fake_alarms[i].id) continue;
+        fake_alarm_next_id = fake_alarm_next_id == INT32_MAX ? 1 : fake_alarm_next_id + 1;
+        fake_alarms[i] = (fake_alarm_t){ fake_alarm_next_id, fake_time_us + us, callback, user_data };
+        return fake_alarm_next_id;
+    }
+    return -1;
+}
+
+bool cancel_alarm(alarm_id_t id) {
+    for (int i = 0; i < FAKE_ALARMS; i++) {
+        if (id > 0 && fake_alarms[i].id == id) {
+            fake_alarms[i].id = 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool add_repeating_timer_us(int64_t delay_us, repeating_timer_callback_t callback, void *user_data,
+                            repeating_timer_t *out) {
+    uint64_t period = (uint64_t)(delay_us < 0 ? -delay_us : delay_us);
+    *out = (repeating_timer_t){ delay_us, fake_time_us + period, callback, user_data, true, fake_timers };
+    fake_timers = out;
+    return true;
+}
+
+bool cancel_repeating_timer(repeating_timer_t *timer) {
+    for (repeating_timer_t **link = &fake_timers; *link; link = &(*link)->next) {
+        if (*link == timer) {
+            *link = timer->next;
+            timer->active = false;
+            return true;
+        }
+    }
+    return false;
+}
+
+// ---------------------------------------------------------------------------
+// hardware/sync.h
+// ---------------------------------------------------------------------------
+
+uint32_t save_and_disable_interrupts(void) {
+    return 0;
+}
+
+void restore_interrupts(uint32_t status) {
+    (void)status;
+}
+
+void __wfe(void) {
+    // Sleep until an event; once nothing is left that could raise one, wake spuriously after 1ms
+    uint64_t when;
+    if (fake_wait_event(fake_time_us)) return;
+    while (fake_next_due(&when))
+        if (fake_wait_event(when)) return;
+    fake_advance_us(1000);
+}
+
+void __wfi(void) {
+    __wfe();
+}
+
+void __sev(void) {
+    fake_event = true;
+}
+
+void __dmb(void) {
+}
+
+int spin_lock_claim_unused(bool required) {
+    (void)required;
+    return 0;
+}
+
+spin_lock_t *spin_lock_init(uint lock_num) {
+    static spin_lock_t locks[32];
+    return &locks[lock_num % 32];
+}
+
+uint32_t spin_lock_blocking(spin_lock_t *lock) {
+    (void)lock;
+    return 0;
+}
+
+void spin_unlock(spin_lock_t *lock, uint32_t saved_irq) {
+    (void)lock;
+    (void)saved_irq;
+}
+
+// ---------------------------------------------------------------------------
+// hardware/gpio.h
+// ---------------------------------------------------------------------------
+
+void gpio_init(uint gpio) {
+    fake_calls.other++;
+    if (gpio >= FAKE_GPIO_COUNT) return;
+    fake_gpio_out_bits &= ~(1ull << gpio);
+    fake_io_bank0.io[gpio].ctrl = GPIO_FUNC_SIO;
+}
+
+void gpio_init_mask(uint32_t mask) {
+    for (uint gpio = 0; gpio < 32; gpio++)
+        if (mask & (1u << gpio)) gpio_init(gpio);
+}
+
+void gpio_set_dir(uint gpio, bool out) {
+    (void)gpio;
+    (void)out;
+    fake_calls.other++;
+}
+
+void gpio_set_dir_out_masked(uint32_t mask) {
+    (void)mask;
+    fake_calls.other++;
+}
+
+void gpio_put(uint gpio, bool value) {
+    fake_calls.gpio_put++;
+    fake_log_write(FAKE_GPIO_PUT, gpio, value);
+    if (gpio >= FAKE_GPIO_COUNT) return;
+    if (value) fake_gpio_out_bits |= 1ull << gpio;
+    else fake_gpio_out_bits &= ~(1ull << gpio);
+}
+
+void gpio_put_masked(uint32_t mask, uint32_t value) {
+    fake_calls.gpio_put_masked++;
+    fake_log_write(FAKE_GPIO_PUT_MASKED, mask, value);
+    fake_gpio_out_bits = (fake_gpio_out_bits & ~(uint64_t)mask) | (value & mask);
+}
+
+bool gpio_get(uint gpio) {
+    if (gpio == IR_PIN) return fake_ir_level;
+    return fake_gpio_out(gpio);
+}
+
+void gpio_pull_up(uint gpio) {
+    (void)gpio;
+    fake_calls.other++;
+}
+
+void gpio_set_function(uint gpio, gpio_function_t fn) {
+    fake_calls.gpio_set_function++;
+    fake_log_write(FAKE_GPIO_FUNCTION, gpio, fn);
+    if (gpio < FAKE_GPIO_COUNT) fake_io_bank0.io[gpio].ctrl = fn;
+}
+
+// ---------------------------------------------------------------------------
+// hardware/structs/io_bank0.h
+// ---------------------------------------------------------------------------
+
+void hw_write_masked(io_rw_32 *addr, uint32_t values, uint32_t write_mask) {
+    *addr = (*addr & ~write_mask) | (values & write_mask);
+    
+    // A pin's ctrl register: count and log a function change as gpio_set_function() does
+    for (uint gpio = 0; gpio < FAKE_GPIO_COUNT; gpio++) {
+        if (addr != &fake_io_bank0.io[gpio].ctrl || !(write_mask & IO_BANK0_GPIO0_CTRL_FUNCSEL_BITS)) continue;
+        fake_calls.gpio_set_function++;
+        fake_log_write(FAKE_GPIO_FUNCTION, gpio, *addr & IO_BANK0_GPIO0_CTRL_FUNCSEL_BITS);
+    }
+}
+
+void gpio_set_irq_enabled(uint gpio, uint32_t event_mask, bool enabled) {
+    if (gpio != IR_PIN) return;
+    if (enabled) fake_gpio_irq_mask |= event_mask;
+    else fake_gpio_irq_mask &= ~event_mask;
+}
+
+void gpio_set_irq_enabled_with_callback(uint gpio, uint32_t event_mask, bool enabled, gpio_irq_callback_t callback) {
+    fake_gpio_irq_callback = callback;
+    gpio_set_irq_enabled(gpio, event_mask, enabled);
+}
+
+// ---------------------------------------------------------------------------
+// hardware/pwm.h and hardware/clocks.h
+// ---------------------------------------------------------------------------
+
+void pwm_set_chan_level(uint slice_num, uint chan, uint16_t level) {
+    uint32_t index = (slice_num % FAKE_PWM_SLICES) * 2 + (chan & 1u);
+    fake_calls.pwm_set_chan_level++;
+    fake_log_write(FAKE_PWM_LEVEL, index, level);
+    fake_pwm_levels[index] = level;
+}
+
+void pwm_set_wrap(uint slice_num, uint16_t wrap) {
+    fake_calls.other++;
+    fake_pwm_wraps[slice_num % FAKE_PWM_SLICES] = wrap;
+}
+
+void pwm_set_clkdiv(uint slice_num, float divider) {
+    (void)slice_num;
+    (void)divider;
+    fake_calls.other++;
+}
+
+void pwm_set_phase_correct(uint slice_num, bool phase_correct) {
+    (void)slice_num;
+    (void)phase_correct;
+    fake_calls.other++;
+}
+
+void pwm_set_enabled(uint slice_num, bool enabled) {
+    (void)slice_num;
+    (void)enabled;
+    fake_calls.other++;
+}
+
+uint32_t clock_get_hz(enum clock_index clk_index) {
+    (void)clk_index;
+    return SYS_CLK_HZ;
+}
+
+// ---------------------------------------------------------------------------
+// hardware/pio.h and hardware/dma.h
+// ---------------------------------------------------------------------------
+
+uint pio_add_program(PIO pio, const pio_program_t *program) {
+    (void)pio;
+    (void)program;
+    return 0;
+}
+
+int pio_claim_unused_sm(PIO pio, bool required) {
+    (void)pio;
+    (void)required;
+    return 0;
+}
+
+uint pio_get_dreq(PIO pio, uint sm, bool is_tx) {
+    (void)pio;
+    return sm + (is_tx ? 0u : 4u);
+}
+
+void pio_sm_init(PIO pio, uint sm, uint initial_pc, const pio_sm_config *config) {
+    (void)pio;
+    (void)sm;
+    (void)initial_pc;
+    (void)config;
+}
+
+void pio_sm_set_enabled(PIO pio, uint sm, bool enabled) {
+    (void)pio;
+    (void)sm;
+    (void)enabled;
+}
+
+pio_sm_config pio_get_default_sm_config(void) {
+    return (pio_sm_config){ 0 };
+}
+
+void sm_config_set_in_pins(pio_sm_config *c, uint in_base) {
+    c->pinctrl = in_base;
+}
+
+void sm_config_set_jmp_pin(pio_sm_config *c, uint pin) {
+    c->execctrl = pin;
+}
+
+void sm_config_set_fifo_join(pio_sm_config *c, enum pio_fifo_join join) {
+    c->shiftctrl = (uint32_t)join;
+}
+
+void sm_config_set_clkdiv(pio_sm_config *c, float div) {
+    c->clkdiv = (uint32_t)(div * 256.0f);
+}
+
+void fake_pio_capture_start(uint pin) {
+    (void)pin;
+    
+    // The program waits for a falling edge before it times anything
+    fake_capture_on = true;
+    fake_capture_synced = false;
+    fake_capture_start_us = fake_time_us;
+}
+
+int dma_claim_unused_channel(bool required) {
+    (void)required;
+    return 0;
+}
+
+dma_channel_config dma_channel_get_default_config(uint channel) {
+    (void)channel;
+    return (dma_channel_config){ 0 };
+}
+
+void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size size) {
+    (void)c;
+    (void)size;
+}
+
+void channel_config_set_read_increment(dma_channel_config *c, bool incr) {
+    (void)c;
+    (void)incr;
+}
+
+void channel_config_set_write_increment(dma_channel_config *c, bool incr) {
+    (void)c;
+    (void)incr;
+}
+
+void channel_config_set_ring(dma_channel_config *c, bool write, uint size_bits) {
+    c->ring_bits = write ? size_bits : 0;
+}
+
+void channel_config_set_dreq(dma_channel_config *c, uint dreq) {
+    (void)c;
+    (void)dreq;
+}
+
+void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr,
+                           const volatile void *read_addr, uint32_t transfer_count, bool trigger) {
+    (void)channel;
+    (void)read_addr;
+    (void)transfer_count;
+    (void)trigger;
+    
+    // Only a word-sized ring on the write side is modelled, which is what ir.c sets up
+    fake_dma_base = write_addr;
+    fake_dma_words = config->ring_bits ? (1u << config->ring_bits) / sizeof(uint32_t) : 0;
+    fake_dma_index = 0;
+    fake_dma_hw.write_addr = (uint32_t)(uintptr_t)write_addr;
+}
+
+uint32_t dma_encode_endless_transfer_count(void) {
+    return 0xF0000000u;
+}
+
+dma_channel_hw_t *dma_channel_hw_addr(uint channel) {
+    (void)channel;
+    return &fake_dma_hw;
+}
+
+// ---------------------------------------------------------------------------
+// Flash and USB
+// ---------------------------------------------------------------------------
+
+int flash_safe_execute(void (*func)(void *), void *param, uint32_t enter_exit_timeout_ms) {
+    (void)enter_exit_timeout_ms;
+    func(param);
+    return PICO_OK;
+}
+
+bool flash_safe_execute_core_init(void) {
+    return true;
+}
+
+void flash_range_erase(uint32_t offset, size_t count) {
+    memset(&fake_flash[offset], 0xFF, count);
+}
+
+void flash_range_program(uint32_t offset, const uint8_t *data, size_t count) {
+    // Programming can only clear bits, as on the real part
+    for (size_t i = 0; i < count; i++) fake_flash[offset + i] &= data[i];
+}
+
+bool stdio_usb_connected(void) {
+    return fake_usb_connected;
+}
+
+int stdio_get_until(char *buf, int len, absolute_time_t until) {
+    // Hand over what is queued, never waiting for more
+    (void)until;
+    size_t n = fake_usb_in_len < (size_t)len ? fake_usb_in_len : (size_t)len;
+    memcpy(buf, fake_usb_in, n);
+    fake_usb_in += n;
+    fake_usb_in_len -= n;
+    return n ? (int)n : PICO_ERROR_TIMEOUT;
+}
+
+int putchar_raw(int c) {
+    // Dropped once the capture buffer is full
+    if (fake_usb_out_len < sizeof(fake_usb_out)) fake_usb_out[fake_usb_out_len++] = (uint8_t)c;
+    return c;
+}
+
+uint32_t tud_cdc_write_available(void) {
+    return fake_usb_room;
+}
@@ -0,0 +1,214 @@
+/**
+ * @file fake_sdk.h
+ * @brief Virtual clock, pin model and call counters behind the host build's fake pico SDK
+ * @author Kevin Thomas
+ * @date 2025
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Kevin Thomas
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef FAKE_SDK_H
+#define FAKE_SDK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Number of GPIO pins modelled
+#define FAKE_GPIO_COUNT 48
+
+// Entries kept in the write log
+#define FAKE_LOG_SIZE 256
+
+// PWM channel a pin maps to, as logged for FAKE_PWM_LEVEL (slice * 2 + channel)
+#define FAKE_PWM_CHAN(pin) ((((pin) >> 1) % 12) * 2 + ((pin) & 1))
+
+/**
+ * @brief Hardware writes the motor and IR code can make, in the order made.
+ */
+typedef enum {
+    FAKE_PWM_LEVEL,       // pwm_set_chan_level(): a = FAKE_PWM_CHAN(pin), b = level
+    FAKE_GPIO_PUT,        // gpio_put(): a = pin, b = level
+    FAKE_GPIO_PUT_MASKED, // gpio_put_masked(): a = mask, b = value
+    FAKE_GPIO_FUNCTION    // gpio_set_function(): a = pin, b = function
+} fake_op_t;
+
+/**
+ * @brief One logged hardware write.
+ */
+typedef struct {
+    fake_op_t op;  // What was written
+    uint32_t a;    // First argument, see fake_op_t
+    uint32_t b;    // Second argument, see fake_op_t
+} fake_write_t;
+
+/**
+ * @brief Calls counted per SDK function, cleared by fake_clear_writes().
+ */
+typedef struct {
+    uint32_t pwm_set_chan_level;
+    uint32_t gpio_put;
+    uint32_t gpio_put_masked;
+    uint32_t gpio_set_function;
+    uint32_t other;               // Every other GPIO/PWM configuration call
+} fake_calls_t;
+
+/**
+ * @brief One level held on IR_PIN for a time, as produced by a remote.
+ */
+typedef struct {
+    bool high;    // Receiver output level (idles high, a carrier burst is low)
+    uint32_t us;  // How long the level lasts
+} fake_pulse_t;
+
+// SDK calls made since the last fake_clear_writes()
+extern fake_calls_t fake_calls;
+
+// Hardware writes made since the last fake_clear_writes(), oldest first
+extern fake_write_t fake_log[FAKE_LOG_SIZE];
+extern uint32_t fake_log_count;
+
+/**
+ * @brief Put the whole fake back to power-on state at time 0.
+ *
+ * Clears pins, PWM slices, timers, alarms, the IR waveform, DMA, flash and
+ * the counters.
+ */
+void fake_reset(void);
+
+/**
+ * @brief Clear the call counters and the write log.
+ */
+void fake_clear_writes(void);
+
+/**
+ * @brief Get the virtual time.
+ *
+ * @return uint64_t  Microseconds since fake_reset().
+ */
+uint64_t fake_now_us(void);
+
+/**
+ * @brief Advance the virtual clock by this much on every clock read.
+ *
+ * Models code that busy-waits on the clock. 0 (the default) keeps the clock
+ * still until fake_advance_us() is called.
+ *
+ * @param us  Microseconds added per read.
+ */
+void fake_set_time_step(uint32_t us);
+
+/**
+ * @brief Advance the virtual clock, firing whatever falls due on the way.
+ *
+ * Alarms, repeating timers and IR pulse ends are handled in time order, as
+ * if their interrupts had run at the right moment.
+ *
+ * @param us  Microseconds to advance.
+ */
+void fake_advance_us(uint64_t us);
+
+/**
+ * @brief Get the time the next alarm, timer or IR pulse end falls due.
+ *
+ * @param when  Receives the due time.
+ * @return bool  false if nothing is scheduled.
+ */
+bool fake_next_due(uint64_t *when);
+
+/**
+ * @brief Play a waveform on IR_PIN starting now.
+ *
+ * The pin returns high (idle) after the last pulse. The pulses must stay
+ * valid until they have been played.
+ *
+ * @param pulses  The levels to play, in order.
+ * @param count   The number of pulses.
+ */
+void fake_ir_play(const fake_pulse_t *pulses, size_t count);
+
+/**
+ * @brief Check whether the IR waveform has been played to the end.
+ *
+ * @return bool  true once the last pulse is over.
+ */
+bool fake_ir_done(void);
+
+/**
+ * @brief Get the function a pin was last given with gpio_set_function().
+ *
+ * @param pin  The pin.
+ * @return uint32_t  The gpio_function_t value, GPIO_FUNC_NULL after reset.
+ */
+uint32_t fake_gpio_function(uint32_t pin);
+
+/**
+ * @brief Get the level a pin is driving from SIO (its output register bit).
+ *
+ * @param pin  The pin.
+ * @return bool  The output level.
+ */
+bool fake_gpio_out(uint32_t pin);
+
+/**
+ * @brief Get the PWM compare level of the channel a pin maps to.
+ *
+ * @param pin  The pin.
+ * @return uint16_t  The compare level.
+ */
+uint16_t fake_pwm_level(uint32_t pin);
+
+/**
+ * @brief Get the PWM wrap value of the slice a pin maps to.
+ *
+ * @param pin  The pin.
+ * @return uint16_t  The wrap (top) value.
+ */
+uint16_t fake_pwm_top(uint32_t pin);
+
+/**
+ * @brief Set how much room the USB CDC transmit buffer reports.
+ *
+ * @param connected  What stdio_usb_connected() returns.
+ * @param room       What tud_cdc_write_available() returns.
+ */
+void fake_usb_set(bool connected, uint32_t room);
+
+/**
+ * @brief Queue bytes for stdio_get_until() to return, replacing any left over.
+ *
+ * @param data  The bytes; must stay valid until they have been read.
+ * @param len   Number of bytes.
+ */
+void fake_usb_input(const void *data, size_t len);
+
+/**
+ * @brief Take the bytes written with putchar_raw() since the last call.
+ *
+ * @param buf      Receives the bytes.
+ * @param max      Size of buf.
+ * @return size_t  Number of bytes copied.
+ */
+size_t fake_usb_output(uint8_t *buf, size_t max);
+
+#endif // FAKE_SDK_H
@@ -0,0 +1,82 @@
+/**
+ * @file hardware/pio.h
+ * @brief PIO API of the host build's fake pico SDK
+ * @author Kevin Thomas
+ * @date 2025
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Kevin Thomas
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef HARDWARE_PIO_H
+#define HARDWARE_PIO_H
+
+#include "pico.h"
+
+typedef struct {
+    volatile uint32_t rxf[4];  // RX FIFO read ports, only used as DMA source addresses
+} pio_hw_t;
+
+typedef pio_hw_t *PIO;
+
+extern pio_hw_t fake_pio0_hw;
+#define pio0 (&fake_pio0_hw)
+
+typedef struct {
+    const uint16_t *instructions;
+    uint8_t length;
+    int8_t origin;
+} pio_program_t;
+
+typedef struct {
+    uint32_t clkdiv;
+    uint32_t execctrl;
+    uint32_t shiftctrl;
+    uint32_t pinctrl;
+} pio_sm_config;
+
+enum pio_fifo_join { PIO_FIFO_JOIN_NONE = 0, PIO_FIFO_JOIN_TX = 1, PIO_FIFO_JOIN_RX = 2 };
+
+uint pio_add_program(PIO pio, const pio_program_t *program);
+int pio_claim_unused_sm(PIO pio, bool required);
+uint pio_get_dreq(PIO pio, uint sm, bool is_tx);
+void pio_sm_init(PIO pio, uint sm, uint initial_pc, const pio_sm_config *config);
+void pio_sm_set_enabled(PIO pio, uint sm, bool enabled);
+
+pio_sm_config pio_get_default_sm_config(void);
+void sm_config_set_in_pins(pio_sm_config *c, uint in_base);
+void sm_config_set_jmp_pin(pio_sm_config *c, uint pin);
+void sm_config_set_fifo_join(pio_sm_config *c, enum pio_fifo_join join);
+void sm_config_set_clkdiv(pio_sm_config *c, float div);
+
+/**
+ * @brief Start the fake pulse-width capture on a pin (what ir_capture does).
+ *
+ * From the first falling edge on, every pulse that ends pushes one word into
+ * the DMA ring configured last: a low pulse as its width in microseconds, a
+ * high pulse as the inverted width.
+ *
+ * @param pin  The pin to capture.
+ */
+void fake_pio_capture_start(uint pin);
+
+#endif // HARDWARE_PIO_H
@@ -0,0 +1,50 @@
+/**
+ * @file hardware/pwm.h
+ * @brief PWM API of the host build's fake pico SDK, with call counting
+ * @author Kevin Thomas
+ * @date 2025
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Kevin Thomas
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef HARDWARE_PWM_H
+#define HARDWARE_PWM_H
+
+#include "pico.h"
+
+// RP2350 maps GPIO 0-31 onto slices 0-7 and 32-47 onto slices 8-11
+static inline uint pwm_gpio_to_slice_num(uint gpio) {
+    return (gpio >> 1u) % 12u;
+}
+
+static inline uint pwm_gpio_to_channel(uint gpio) {
+    return gpio & 1u;
+}
+
+void pwm_set_chan_level(uint slice_num, uint chan, uint16_t level);
+void pwm_set_wrap(uint slice_num, uint16_t wrap);
+void pwm_set_clkdiv(uint slice_num, float divider);
+void pwm_set_phase_correct(uint slice_num, bool phase_correct);
+void pwm_set_enabled(uint slice_num, bool enabled);
+
+#endif // HARDWARE_PWM_H
@@ -0,0 +1,56 @@
+/**
+ * @file hardware/structs/io_bank0.h
+ * @brief IO bank 0 registers of the host build's fake pico SDK, with function-select logging
+ * @author Kevin Thomas
+ * @date 2025
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Kevin Thomas
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef HARDWARE_STRUCTS_IO_BANK0_H
+#define HARDWARE_STRUCTS_IO_BANK0_H
+
+#include <stdint.h>
+
+typedef volatile uint32_t io_rw_32;
+
+#define IO_BANK0_GPIO0_CTRL_FUNCSEL_LSB  0u
+#define IO_BANK0_GPIO0_CTRL_FUNCSEL_BITS 0x0000001fu
+
+typedef struct {
+    io_rw_32 status;
+    io_rw_32 ctrl;
+} io_bank0_status_ctrl_hw_t;
+
+typedef struct {
+    io_bank0_status_ctrl_hw_t io[48];
+} io_bank0_hw_t;
+
+// Register block behind io_bank0_hw; a pin's function is the FUNCSEL field of its ctrl
+extern io_bank0_hw_t fake_io_bank0;
+#define io_bank0_hw (&fake_io_bank0)
+
+// Masked register write; a write to a pin's ctrl is logged like gpio_set_function()
+void hw_write_masked(io_rw_32 *addr, uint32_t values, uint32_t write_mask);
+
+#endif // HARDWARE_STRUCTS_IO_BANK0_H
@@ -0,0 +1,52 @@
+/**
+ * @file hardware/sync.h
+ * @brief Interrupt and spin lock API of the host build's fake pico SDK
+ * @author Kevin Thomas
+ * @date 2025
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Kevin Thomas
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef HARDWARE_SYNC_H
+#define HARDWARE_SYNC_H
+
+#include "pico.h"
+
+typedef volatile uint32_t spin_lock_t;
+
+// Interrupts are simulated by fake_advance_us(), so masking them is a no-op
+uint32_t save_and_disable_interrupts(void);
+void restore_interrupts(uint32_t status);
+
+// WFE advances the clock until __sev() or an interrupt (alarm, timer, enabled IR edge) signals an event
+void __wfe(void);
+void __wfi(void);
+void __sev(void);
+void __dmb(void);
+
+int spin_lock_claim_unused(bool required);
+spin_lock_t *spin_lock_init(uint lock_num);
+uint32_t spin_lock_blocking(spin_lock_t *lock);
+void spin_unlock(spin_lock_t *lock, uint32_t saved_irq);
+
+#endif // HARDWARE_SYNC_H
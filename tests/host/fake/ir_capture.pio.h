@@ -0,0 +1,60 @@
+/**
+ * @file ir_capture.pio.h
+ * @brief Host stand-in for the header pioasm generates from ir_capture.pio
+ * @author Kevin Thomas
+ * @date 2025
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Kevin Thomas
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef IR_CAPTURE_PIO_H
+#define IR_CAPTURE_PIO_H
+
+#include "hardware/pio.h"
+#include "hardware/clocks.h"
+
+static const uint16_t ir_capture_program_instructions[] = { 0 };
+
+static const pio_program_t ir_capture_program = {
+    .instructions = ir_capture_program_instructions,
+    .length = 1,
+    .origin = -1,
+};
+
+static inline pio_sm_config ir_capture_program_get_default_config(uint offset) {
+    (void)offset;
+    return pio_get_default_sm_config();
+}
+
+// Same signature as the generated helper; starts the fake pulse-width capture
+static inline void ir_capture_program_init(PIO pio, uint sm, uint offset, uint pin) {
+    pio_sm_config c = ir_capture_program_get_default_config(offset);
+    sm_config_set_in_pins(&c, pin);
+    sm_config_set_jmp_pin(&c, pin);
+    sm_config_set_fifo_join(&c, PIO_FIFO_JOIN_RX);
+    pio_sm_init(pio, sm, offset, &c);
+    pio_sm_set_enabled(pio, sm, true);
+    fake_pio_capture_start(pin);
+}
+
+#endif // IR_CAPTURE_PIO_H
@@ -0,0 +1,78 @@
+/**
+ * @file pico/time.h
+ * @brief Virtual-clock time, alarm and timer API of the host build's fake pico SDK
+ * @author Kevin Thomas
+ * @date 2025
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Kevin Thomas
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef PICO_TIME_H
+#define PICO_TIME_H
+
+#include "pico.h"
+
+#define PICO_OK 0
+#define PICO_ERROR_TIMEOUT (-1)
+
+typedef uint64_t absolute_time_t;
+typedef int32_t alarm_id_t;
+typedef int64_t (*alarm_callback_t)(alarm_id_t id, void *user_data);
+
+typedef struct repeating_timer repeating_timer_t;
+typedef bool (*repeating_timer_callback_t)(repeating_timer_t *rt);
+
+/**
+ * @brief A repeating timer; the fake keeps its schedule in here.
+ */
+struct repeating_timer {
+    int64_t delay_us;                     // Negative: start to start, positive: end to start
+    uint64_t due_us;                      // Next time the callback runs
+    repeating_timer_callback_t callback;  // Called on every period
+    void *user_data;                      // Passed through to the callback
+    bool active;                          // Cleared once the callback returns false
+    struct repeating_timer *next;         // Next active timer
+};
+
+uint32_t time_us_32(void);
+uint64_t time_us_64(void);
+absolute_time_t get_absolute_time(void);
+int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to);
+uint64_t to_us_since_boot(absolute_time_t t);
+absolute_time_t make_timeout_time_us(uint64_t us);
+absolute_time_t make_timeout_time_ms(uint32_t ms);
+absolute_time_t delayed_by_us(absolute_time_t t, uint64_t us);
+
+void sleep_us(uint64_t us);
+void sleep_ms(uint32_t ms);
+void sleep_until(absolute_time_t t);
+void busy_wait_us(uint64_t us);
+bool best_effort_wfe_or_timeout(absolute_time_t t);
+
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void *user_data, bool fire_if_past);
+bool cancel_alarm(alarm_id_t id);
+bool add_repeating_timer_us(int64_t delay_us, repeating_timer_callback_t callback, void *user_data,
+                            repeating_timer_t *out);
+bool cancel_repeating_timer(repeating_timer_t *timer);
+
+#endif // PICO_TIME_H
@@ -0,0 +1,181 @@
+/**
+ * @file ir_wave.c
+ * @brief Scriptable IR receiver waveforms for the host tests and bench
+ * @author Kevin Thomas
+ * @date 2025
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Kevin Thomas
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "ir_wave.h"
+
+// Protocol timings, in microseconds
+#define NEC_LEADER_MARK   9000
+#define NEC_LEADER_SPACE  4500
+#define NEC_REPEAT_SPACE  2250
+#define NEC_MARK          560
+#define NEC_ZERO_SPACE    560
+#define NEC_ONE_SPACE     1690
+#define RC5_HALF_BIT      889
+#define SIRC_LEADER_MARK  2400
+#define SIRC_SPACE        600
+#define SIRC_ZERO_MARK    600
+#define SIRC_ONE_MARK     1200
+
+// Pulses this long or longer may be split by a glitch
+#define GLITCH_MIN_PULSE_US 400
+
+// A glitch leaves at least this much of the pulse on either side (IR_GLITCH_US)
+#define GLITCH_EDGE_US 150
+
+void ir_wave_init(ir_wave_t *w, fake_pulse_t *buf, size_t cap, const ir_wave_impair_t *impair) {
+    w->pulses = buf;
+    w->count = 0;
+    w->cap = cap;
+    w->impair = impair ? *impair : (ir_wave_impair_t){ 0 };
+    if (w->impair.clock_scale == 0) w->impair.clock_scale = 1.0;
+    w->rng = w->impair.seed ? w->impair.seed : 0x2545F491u;
+    w->duration_us = 0;
+}
+
+uint32_t ir_wave_random(ir_wave_t *w, uint32_t n) {
+    // xorshift32
+    w->rng ^= w->rng << 13;
+    w->rng ^= w->rng >> 17;
+    w->rng ^= w->rng << 5;
+    return n ? w->rng % n : 0;
+}
+
+/**
+ * @brief Append a level exactly as given, merging it into an equal previous level.
+ *
+ * @param w     The waveform.
+ * @param high  The level.
+ * @param us    The width.
+ */
+static void ir_wave_raw(ir_wave_t *w, bool high, uint32_t us) {
+    if (us == 0) return;
+    w->duration_us += us;
+    if (w->count && w->pulses[w->count - 1].high == high) {
+        w->pulses[w->count - 1].us += us;
+        return;
+    }
+    if (w->count < w->cap) w->pulses[w->count++] = (fake_pulse_t){ high, us };
+}
+
+void ir_wave_pulse(ir_wave_t *w, bool high, uint32_t us) {
+    // Remote clock error, then per-pulse jitter
+    int64_t t = (int64_t)(us * w->impair.clock_scale + 0.5);
+    if (w->impair.jitter_us)
+        t += (int64_t)ir_wave_random(w, 2 * w->impair.jitter_us + 1) - w->impair.jitter_us;
+    if (t < 1) t = 1;
+    
+    // A glitch splits the pulse with a short spike of the other level
+    if (w->impair.glitch_rate > 0 && t >= GLITCH_MIN_PULSE_US &&
+        ir_wave_random(w, 1000000) < (uint32_t)(w->impair.glitch_rate * 1000000)) {
+        uint32_t spike = 10 + ir_wave_random(w, 61);
+        uint32_t before = GLITCH_EDGE_US + ir_wave_random(w, (uint32_t)t - 2 * GLITCH_EDGE_US - spike);
+        ir_wave_raw(w, high, before);
+        ir_wave_raw(w, !high, spike);
+        ir_wave_raw(w, high, (uint32_t)t - before - spike);
+        return;
+    }
+    ir_wave_raw(w, high, (uint32_t)t);
+}
+
+void ir_wave_idle(ir_wave_t *w, uint32_t us) {
+    ir_wave_raw(w, true, us);
+}
+
+void ir_wave_noise(ir_wave_t *w, uint32_t us) {
+    // Short marks at random intervals
+    uint64_t end = w->duration_us + us;
+    while (w->duration_us + 200 < end) {
+        ir_wave_raw(w, false, 20 + ir_wave_random(w, 100));
+        uint32_t gap = 100 + ir_wave_random(w, 1400);
+        if (w->duration_us + gap > end) gap = (uint32_t)(end - w->duration_us);
+        ir_wave_raw(w, true, gap);
+    }
+    if (w->duration_us < end) ir_wave_raw(w, true, (uint32_t)(end - w->duration_us));
+}
+
+void ir_wave_nec_raw(ir_wave_t *w, uint32_t data) {
+    ir_wave_pulse(w, false, NEC_LEADER_MARK);
+    ir_wave_pulse(w, true, NEC_LEADER_SPACE);
+    for (int i = 0; i < 32; i++) {
+        ir_wave_pulse(w, false, NEC_MARK);
+        ir_wave_pulse(w, true, (data >> i) & 1 ? NEC_ONE_SPACE : NEC_ZERO_SPACE);
+    }
+    ir_wave_pulse(w, false, NEC_MARK);
+}
+
+void ir_wave_nec(ir_wave_t *w, uint8_t address, uint8_t command) {
+    ir_wave_nec_raw(w, address | (uint32_t)(uint8_t)~address << 8 |
+                       (uint32_t)command << 16 | (uint32_t)(uint8_t)~command << 24);
+}
+
+void ir_wave_nec_ext(ir_wave_t *w, uint16_t address, uint8_t command) {
+    ir_wave_nec_raw(w, address | (uint32_t)command << 16 | (uint32_t)(uint8_t)~command << 24);
+}
+
+void ir_wave_nec_repeat(ir_wave_t *w) {
+    ir_wave_pulse(w, false, NEC_LEADER_MARK);
+    ir_wave_pulse(w, true, NEC_REPEAT_SPACE);
+    ir_wave_pulse(w, false, NEC_MARK);
+}
+
+void ir_wave_rc5(ir_wave_t *w, uint8_t address, uint8_t command, bool toggle) {
+    // S1, S2 (inverted command bit 6 for RC5X), toggle, 5 address bits, 6 command bits
+    uint32_t data = 1u << 13 | (uint32_t)!(command & 0x40) << 12 | (uint32_t)toggle << 11 |
+                    (uint32_t)(address & 0x1F) << 6 | (command & 0x3F);
+    
+    // Manchester, MSB first: a '1' is a space then a mark, a '0' a mark then a space
+    for (int i = 13; i >= 0; i--) {
+        bool one = (data >> i) & 1;
+        ir_wave_pulse(w, one, RC5_HALF_BIT);
+        ir_wave_pulse(w, !one, RC5_HALF_BIT);
+    }
+}
+
+void ir_wave_sirc(ir_wave_t *w, uint8_t command, uint16_t address, int bits) {
+    uint32_t data = (command & 0x7Fu) | (uint32_t)address << 7;
+    
+    // Leader, then pulse-width bits LSB first, each followed by a fixed space
+    ir_wave_pulse(w, false, SIRC_LEADER_MARK);
+    ir_wave_pulse(w, true, SIRC_SPACE);
+    for (int i = 0; i < bits; i++) {
+        ir_wave_pulse(w, false, (data >> i) & 1 ? SIRC_ONE_MARK : SIRC_ZERO_MARK);
+        if (i < bits - 1) ir_wave_pulse(w, true, SIRC_SPACE);
+    }
+}
+
+size_t ir_wave_edges(const ir_wave_t *w, uint32_t *edges, size_t cap) {
+    size_t n = 0;
+    size_t i = 0;
+    
+    // Nothing is captured before the first falling edge
+    while (i < w->count && w->pulses[i].high) i++;
+    for (; i < w->count && n < cap; i++)
+        edges[n++] = w->pulses[i].high ? ~w->pulses[i].us : w->pulses[i].us;
+    return n;
+}
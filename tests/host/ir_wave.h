@@ -0,0 +1,172 @@
+/**
+ * @file ir_wave.h
+ * @brief Scriptable IR receiver waveforms for the host tests and bench
+ * @author Kevin Thomas
+ * @date 2025
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Kevin Thomas
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef IR_WAVE_H
+#define IR_WAVE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "fake_sdk.h"
+
+/**
+ * @brief How far a waveform strays from an ideal remote.
+ */
+typedef struct {
+    double clock_scale;   // Remote clock relative to nominal, 1.0 for exact (0 is taken as 1.0)
+    uint32_t jitter_us;   // Every pulse is moved by up to this much either way
+    double glitch_rate;   // Chance that a pulse over 400us is split by a 10-70us spike, 150us or more from its ends
+    uint32_t seed;        // Random seed, 0 picks a fixed default
+} ir_wave_impair_t;
+
+/**
+ * @brief A waveform being built into a caller-supplied pulse buffer.
+ */
+typedef struct {
+    fake_pulse_t *pulses;     // Pulse buffer
+    size_t count;             // Pulses written
+    size_t cap;               // Buffer size in pulses
+    ir_wave_impair_t impair;  // Impairments applied to every pulse added
+    uint32_t rng;             // xorshift32 state
+    uint64_t duration_us;     // Total length of the waveform
+} ir_wave_t;
+
+/**
+ * @brief Start an empty waveform.
+ *
+ * @param w       The waveform.
+ * @param buf     Pulse storage.
+ * @param cap     Number of pulses buf holds; extra pulses are dropped.
+ * @param impair  Impairments to apply, or NULL for a clean signal.
+ */
+void ir_wave_init(ir_wave_t *w, fake_pulse_t *buf, size_t cap, const ir_wave_impair_t *impair);
+
+/**
+ * @brief Get a pseudo-random number from the waveform's generator.
+ *
+ * @param w  The waveform.
+ * @param n  The number of possible values.
+ * @return uint32_t  A value in 0..n-1.
+ */
+uint32_t ir_wave_random(ir_wave_t *w, uint32_t n);
+
+/**
+ * @brief Append one level, with the impairments applied.
+ *
+ * A level equal to the previous one extends it.
+ *
+ * @param w     The waveform.
+ * @param high  true for a space (receiver idle), false for a mark.
+ * @param us    The nominal width.
+ */
+void ir_wave_pulse(ir_wave_t *w, bool high, uint32_t us);
+
+/**
+ * @brief Append idle (high) time, never impaired.
+ *
+ * @param w   The waveform.
+ * @param us  The idle time.
+ */
+void ir_wave_idle(ir_wave_t *w, uint32_t us);
+
+/**
+ * @brief Append a burst of random short marks, as from a lamp or another remote.
+ *
+ * @param w   The waveform.
+ * @param us  The length of the burst.
+ */
+void ir_wave_noise(ir_wave_t *w, uint32_t us);
+
+/**
+ * @brief Append a standard NEC frame (address, ~address, command, ~command).
+ *
+ * @param w        The waveform.
+ * @param address  The 8-bit address.
+ * @param command  The command.
+ */
+void ir_wave_nec(ir_wave_t *w, uint8_t address, uint8_t command);
+
+/**
+ * @brief Append an NEC frame with arbitrary data bits, checksums not enforced.
+ *
+ * @param w     The waveform.
+ * @param data  The 32 data bits, sent LSB first.
+ */
+void ir_wave_nec_raw(ir_wave_t *w, uint32_t data);
+
+/**
+ * @brief Append an extended NEC frame (16-bit address, command, ~command).
+ *
+ * @param w        The waveform.
+ * @param address  The 16-bit address; must not be a byte and its complement.
+ * @param command  The command.
+ */
+void ir_wave_nec_ext(ir_wave_t *w, uint16_t address, uint8_t command);
+
+/**
+ * @brief Append an NEC repeat code.
+ *
+ * @param w  The waveform.
+ */
+void ir_wave_nec_repeat(ir_wave_t *w);
+
+/**
+ * @brief Append an RC5 frame; commands above 63 are sent as RC5X.
+ *
+ * @param w        The waveform.
+ * @param address  The 5-bit address.
+ * @param command  The 6-bit (7-bit with RC5X) command.
+ * @param toggle   The toggle bit.
+ */
+void ir_wave_rc5(ir_wave_t *w, uint8_t address, uint8_t command, bool toggle);
+
+/**
+ * @brief Append a Sony SIRC frame.
+ *
+ * @param w        The waveform.
+ * @param command  The 7-bit command.
+ * @param address  The 5, 8 or 13-bit address.
+ * @param bits     The frame length: 12, 15 or 20.
+ */
+void ir_wave_sirc(ir_wave_t *w, uint8_t command, uint16_t address, int bits);
+
+/**
+ * @brief Convert a waveform to the words the capture PIO program would push.
+ *
+ * Capture starts at the first falling edge. Every pulse from there on becomes
+ * one word, the last one included, as if another edge followed it.
+ *
+ * @param w      The waveform.
+ * @param edges  Receives the edge words.
+ * @param cap    Number of words edges holds.
+ * @return size_t  The number of words written.
+ */
+size_t ir_wave_edges(const ir_wave_t *w, uint32_t *edges, size_t cap);
+
+#endif // IR_WAVE_H
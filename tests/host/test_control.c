@@ -0,0 +1,313 @@
+/**
+ * @file test_control.c
+ * @brief Step the control tick on the virtual clock: failsafe timing and duty slewing
+ * @author Kevin Thomas
+ * @date 2025
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Kevin Thomas
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "check.h"
+#include "fake_sdk.h"
+#include "control.h"
+#include "robot.h"
+#include "ir.h"
+
+// Direction pins all high: short brake
+#define DIR_PINS_HIGH (fake_gpio_out(AIN1) && fake_gpio_out(AIN2) && fake_gpio_out(BIN1) && fake_gpio_out(BIN2))
+
+/**
+ * @brief Start the motor driver and the control tick at time 0.
+ */
+static void control_setup(void) {
+    fake_reset();
+    motor_init();
+    control_init(NULL);
+    control_set_ramp(CONTROL_ACCEL_DEFAULT, CONTROL_DECEL_DEFAULT);
+}
+
+/**
+ * @brief Get the duty applied to the left motor by the last tick.
+ */
+static int32_t applied_left(void) {
+    int32_t left, right;
+    control_get_applied(&left, &right);
+    return left;
+}
+
+/**
+ * @brief control_slew() on its own: accel away from zero, decel toward it, stop before reversing.
+ */
+static void test_slew(void) {
+    const uint16_t accel = 200, decel = 650;
+    
+    // Speeding up, either direction, lands exactly on the target
+    CHECK_EQ(control_slew(0, 1000, accel, decel), 200);
+    CHECK_EQ(control_slew(900, 1000, accel, decel), 1000);
+    CHECK_EQ(control_slew(0, -1000, accel, decel), -200);
+    CHECK_EQ(control_slew(-900, -1000, accel, decel), -1000);
+    
+    // Slowing down uses decel
+    CHECK_EQ(control_slew(1000, 0, accel, decel), 350);
+    CHECK_EQ(control_slew(1000, 500, accel, decel), 500);
+    CHECK_EQ(control_slew(-1000, 0, accel, decel), -350);
+    CHECK_EQ(control_slew(-1000, -100, accel, decel), -350);
+    
+    // Reversing stops at zero first, never crossing it in one step
+    CHECK_EQ(control_slew(1000, -1000, accel, decel), 350);
+    CHECK_EQ(control_slew(300, -1000, accel, decel), 0);
+    CHECK_EQ(control_slew(0, -1000, accel, decel), -200);
+    CHECK_EQ(control_slew(-300, 1000, accel, decel), 0);
+    
+    // At the target nothing moves
+    CHECK_EQ(control_slew(1234, 1234, accel, decel), 1234);
+}
+
+/**
+ * @brief The tick ramps at accel per tick up and decel per tick down.
+ */
+static void test_tick_ramp(void) {
+    control_setup();
+    control_set_target(30000, 30000);
+    
+    // Ten ticks of accel
+    fake_advance_us(10 * CONTROL_TICK_US);
+    CHECK_EQ(applied_left(), 10 * CONTROL_ACCEL_DEFAULT);
+    
+    // 30000 takes 150 ticks
+    fake_advance_us(140 * CONTROL_TICK_US);
+    CHECK_EQ(applied_left(), 30000);
+    
+    // Ten ticks of decel
+    control_set_target(0, 0);
+    fake_advance_us(10 * CONTROL_TICK_US);
+    CHECK_EQ(applied_left(), 30000 - 10 * CONTROL_DECEL_DEFAULT);
+    CHECK(!control_tripped());
+}
+
+/**
+ * @brief Reversing through the tick passes through zero, one limited step per tick.
+ */
+static void test_tick_reverse(void) {
+    control_setup();
+    control_set_target(20000, 20000);
+    fake_advance_us(200 * CONTROL_TICK_US);
+    CHECK_EQ(applied_left(), 20000);
+    
+    control_set_target(-20000, -20000);
+    int32_t prev = applied_left();
+    bool seen_zero = false;
+    for (int i = 0; i < 200; i++) {
+        fake_advance_us(CONTROL_TICK_US);
+        int32_t now = applied_left();
+        
+        // Each tick moves by at most the limit that applies on its side of zero
+        int32_t step = prev > 0 ? CONTROL_DECEL_DEFAULT : CONTROL_ACCEL_DEFAULT;
+        CHECK(prev - now >= 0 && prev - now <= step);
+        
+        // The sign only changes after a tick at exactly zero
+        CHECK(!(prev > 0 && now < 0));
+        if (now == 0) seen_zero = true;
+        if (now < 0) CHECK(seen_zero);
+        prev = now;
+    }
+    CHECK_EQ(prev, -20000);
+}
+
+/**
+ * @brief Without commands the drive is cut within one tick of CONTROL_FAILSAFE_US.
+ */
+static void test_failsafe(void) {
+    control_setup();
+    control_set_target(30000, 30000);
+    uint64_t cmd_us = fake_now_us();
+    
+    // Still driving a tick before the deadline
+    fake_advance_us(CONTROL_FAILSAFE_US - CONTROL_TICK_US);
+    CHECK(!control_tripped());
+    CHECK_EQ(applied_left(), 30000);
+    CHECK(fake_pwm_level(PWMA) > 0);
+    
+    // Step tick by tick until the failsafe fires
+    while (!control_tripped() && fake_now_us() < cmd_us + 2 * CONTROL_FAILSAFE_US)
+        fake_advance_us(CONTROL_TICK_US);
+    CHECK(control_tripped());
+    uint64_t late = fake_now_us() - cmd_us;
+    CHECK(late > CONTROL_FAILSAFE_US && late <= CONTROL_FAILSAFE_US + CONTROL_TICK_US);
+    
+    // The same tick cut the drive: no duty and a short brake on the bridge
+    CHECK_EQ(applied_left(), 0);
+    CHECK_EQ(fake_pwm_level(PWMA), 0);
+    CHECK_EQ(fake_pwm_level(PWMB), 0);
+    CHECK(DIR_PINS_HIGH);
+    
+    // A new command clears the trip on the next tick
+    control_set_target(1000, 1000);
+    fake_advance_us(CONTROL_TICK_US);
+    CHECK(!control_tripped());
+}
+
+/**
+ * @brief Once tripped the failsafe holds when the 32-bit clock wraps back to the last command time.
+ */
+static void test_failsafe_wrap(void) {
+    control_setup();
+    control_set_target(30000, 30000);
+    fake_advance_us(CONTROL_FAILSAFE_US + 10 * CONTROL_TICK_US);
+    CHECK(control_tripped());
+    
+    // 2^32 us after the command the deadline looks fresh again
+    fake_advance_us((1ull << 32) - CONTROL_FAILSAFE_US);
+    CHECK(control_tripped());
+    CHECK_EQ(applied_left(), 0);
+    CHECK(!control_braking());
+    CHECK(control_idle());
+    
+    // The next command clears it straight away
+    control_feed();
+    CHECK(!control_tripped());
+    fake_advance_us(CONTROL_TICK_US);
+    CHECK(!control_tripped());
+    CHECK_EQ(applied_left(), 0);
+}
+
+/**
+ * @brief Feeding keeps the motors running well past the failsafe time.
+ */
+static void test_feed(void) {
+    control_setup();
+    control_set_target(30000, 30000);
+    for (int i = 0; i < 30; i++) {
+        fake_advance_us(100000);
+        control_feed();
+    }
+    CHECK(!control_tripped());
+    CHECK_EQ(applied_left(), 30000);
+}
+
+/**
+ * @brief control_idle(): zero targets, zero applied duty and no recent command.
+ */
+static void test_idle(void) {
+    control_setup();
+    
+    // Nothing commanded since start, once any duty left by an earlier test has ramped down
+    fake_advance_us(100000);
+    CHECK(control_idle());
+    
+    // A target, or the ramp still winding down after it, is not idle
+    control_set_target(20000, 20000);
+    CHECK(!control_idle());
+    fake_advance_us(50000);
+    control_set_target(0, 0);
+    fake_advance_us(CONTROL_TICK_US);
+    CHECK(applied_left() != 0);
+    CHECK(!control_idle());
+    
+    // Stopped, but a command came in less than CONTROL_IDLE_US ago
+    fake_advance_us(100000);
+    CHECK_EQ(applied_left(), 0);
+    control_set_target(0, 0);
+    fake_advance_us(CONTROL_IDLE_US - CONTROL_TICK_US);
+    CHECK(!control_idle());
+    fake_advance_us(CONTROL_TICK_US);
+    CHECK(control_idle());
+    
+    // A zero target with the other wheel moving is not idle either
+    control_set_target(0, 20000);
+    fake_advance_us(CONTROL_IDLE_US);
+    CHECK(!control_idle());
+}
+
+/**
+ * @brief Event latency runs to the tick that changes the outputs, and is not taken when none changes.
+ */
+static void test_event_latency(void) {
+    uint32_t latency;
+    control_setup();
+    fake_advance_us(100000);
+    control_take_latency(&latency);
+    
+    // A press 300us before the tick: measured when that tick writes the first ramp step
+    fake_advance_us(CONTROL_TICK_US - 300);
+    uint32_t event_us = (uint32_t)fake_now_us();
+    control_set_target(20000, 20000);
+    control_stamp_event(event_us);
+    CHECK(!control_take_latency(&latency));
+    fake_advance_us(300);
+    CHECK(control_take_latency(&latency));
+    CHECK_EQ(latency, 300);
+    
+    // Held at full target: nothing changes, so nothing is measured
+    fake_advance_us(200000);
+    control_set_target(20000, 20000);
+    control_stamp_event((uint32_t)fake_now_us());
+    fake_advance_us(10 * CONTROL_TICK_US);
+    CHECK(!control_take_latency(&latency));
+    
+    // A stop: measured when the brake goes on
+    event_us = (uint32_t)fake_now_us() - 2000;
+    control_brake(CONTROL_BRAKE_MS);
+    control_stamp_event(event_us);
+    fake_advance_us(CONTROL_TICK_US);
+    CHECK(control_take_latency(&latency));
+    CHECK(latency > 2000 && latency <= 2000 + CONTROL_TICK_US);
+}
+
+/**
+ * @brief Releasing the stop key mid-brake leaves the brake running for CONTROL_BRAKE_MS.
+ */
+static void test_release_during_brake(void) {
+    uint16_t speed = 30000;
+    control_setup();
+    control_set_target(30000, 30000);
+    fake_advance_us(100000);
+    
+    // Stop pressed, then released 150ms into the brake
+    process_ir_event((ir_event_t){ IR_EVENT_PRESS, 0x1C, (uint32_t)fake_now_us() }, &speed);
+    uint64_t stop_us = fake_now_us();
+    fake_advance_us(150000);
+    CHECK(control_braking());
+    process_ir_event((ir_event_t){ IR_EVENT_RELEASE, 0x1C, (uint32_t)fake_now_us() }, &speed);
+    
+    // Still braking until the brake time runs out
+    fake_advance_us(stop_us + CONTROL_BRAKE_MS * 1000 - CONTROL_TICK_US - fake_now_us());
+    CHECK(control_braking());
+    CHECK(DIR_PINS_HIGH);
+    fake_advance_us(2 * CONTROL_TICK_US);
+    CHECK(!control_braking());
+    CHECK_EQ(applied_left(), 0);
+}
+
+int main(void) {
+    test_slew();
+    test_tick_ramp();
+    test_tick_reverse();
+    test_failsafe();
+    test_failsafe_wrap();
+    test_feed();
+    test_idle();
+    test_event_latency();
+    test_release_during_brake();
+    return CHECK_DONE();
+}
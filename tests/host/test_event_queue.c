@@ -0,0 +1,129 @@
+/**
+ * @file test_event_queue.c
+ * @brief Two-thread producer/consumer stress test of the core1-to-core0 event queue
+ * @author Kevin Thomas
+ * @date 2025
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Kevin Thomas
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <limits.h>
+#include "check.h"
+#include "event_queue.h"
+
+// Events sent through the queue per run
+#define STRESS_EVENTS 1000000u
+
+// Queue shared by the two threads, as between core1 and core0
+static event_queue_t queue;
+
+// Times the producer found the queue full
+static unsigned long full_count;
+
+/**
+ * @brief Build the event with sequence number n, every field derived from n.
+ *
+ * @param n  The sequence number.
+ * @return ir_event_t  The event.
+ */
+static ir_event_t stress_event(uint32_t n) {
+    return (ir_event_t){ (ir_event_type_t)(IR_EVENT_PRESS + n % 3), (uint8_t)(n * 7), n };
+}
+
+/**
+ * @brief Producer thread: push every event in order, retrying while full.
+ */
+static void *stress_producer(void *arg) {
+    (void)arg;
+    for (uint32_t n = 0; n < STRESS_EVENTS; n++) {
+        ir_event_t ev = stress_event(n);
+        while (!event_queue_push(&queue, &ev)) {
+            full_count++;
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Run one producer against the calling thread as consumer.
+ *
+ * @param start  Initial value of both indexes, to test their wraparound.
+ */
+static void test_stress(unsigned int start) {
+    event_queue_init(&queue);
+    atomic_store(&queue.head, start);
+    atomic_store(&queue.tail, start);
+    full_count = 0;
+    
+    pthread_t producer;
+    CHECK_EQ(pthread_create(&producer, NULL, stress_producer, NULL), 0);
+    
+    // Every event arrives exactly once, in order and intact
+    uint32_t next = 0, bad = 0;
+    unsigned long empty_count = 0;
+    while (next < STRESS_EVENTS) {
+        ir_event_t ev;
+        if (!event_queue_pop(&queue, &ev)) {
+            empty_count++;
+            sched_yield();
+            continue;
+        }
+        ir_event_t want = stress_event(next);
+        if (ev.time_us != want.time_us || ev.key != want.key || ev.type != want.type) {
+            if (bad++ < 5)
+                fprintf(stderr, "event %lu: got seq %lu key %u type %d\n", (unsigned long)next,
+                        (unsigned long)ev.time_us, ev.key, ev.type);
+        }
+        next++;
+    }
+    pthread_join(producer, NULL);
+    
+    // Nothing extra is left behind
+    ir_event_t ev;
+    CHECK(!event_queue_pop(&queue, &ev));
+    CHECK_EQ(bad, 0);
+    printf("start %u: %u events, producer full %lu times, consumer empty %lu times\n",
+           start, STRESS_EVENTS, full_count, empty_count);
+}
+
+/**
+ * @brief The queue holds exactly EVENT_QUEUE_SIZE events.
+ */
+static void test_capacity(void) {
+    event_queue_init(&queue);
+    ir_event_t ev = stress_event(0);
+    for (int i = 0; i < EVENT_QUEUE_SIZE; i++) CHECK(event_queue_push(&queue, &ev));
+    CHECK(!event_queue_push(&queue, &ev));
+    CHECK(event_queue_pop(&queue, &ev));
+    CHECK(event_queue_push(&queue, &ev));
+}
+
+int main(void) {
+    test_capacity();
+    test_stress(0);
+    test_stress(UINT_MAX - 1000u);
+    return CHECK_DONE();
+}
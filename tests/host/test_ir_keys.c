@@ -0,0 +1,155 @@
+/**
+ * @file test_ir_keys.c
+ * @brief Key press, hold and release tracking of a held NEC key with lost repeats
+ * @author Kevin Thomas
+ * @date 2025
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Kevin Thomas
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "check.h"
+#include "pico.h"
+#include "ir_wave.h"
+#include "ir.h"
+
+// NEC repeat code period
+#define REPEAT_US 108000
+
+// How often core1 polls for key events
+#define POLL_US 1000
+
+// Command byte of the key held
+#define KEY 0x18
+
+// Pulse storage
+static fake_pulse_t pulses[2048];
+
+// Key events reported by the last replay, in order
+static ir_event_t events[64];
+static size_t event_count;
+
+/**
+ * @brief Build a held NEC key: a frame, then repeat codes, leaving out the ones listed.
+ *
+ * @param w        Receives the waveform.
+ * @param repeats  Repeat codes a perfect remote would send.
+ * @param lost     Bit i set drops repeat i (counting from 1).
+ */
+static void hold_key(ir_wave_t *w, int repeats, uint32_t lost) {
+    ir_wave_init(w, pulses, count_of(pulses), &(ir_wave_impair_t){ 1.0, 20, 0, 7 });
+    ir_wave_nec(w, 0x00, KEY);
+    for (int i = 1; i <= repeats; i++) {
+        if (lost & (1u << i)) continue;
+        ir_wave_idle(w, (uint32_t)((uint64_t)i * REPEAT_US - w->duration_us));
+        ir_wave_nec_repeat(w);
+    }
+    ir_wave_idle(w, 2 * IR_RELEASE_US);
+}
+
+/**
+ * @brief Keep an event if there is one.
+ */
+static void record(ir_event_t ev) {
+    if (ev.type != IR_EVENT_NONE && event_count < count_of(events)) events[event_count++] = ev;
+}
+
+/**
+ * @brief Play a waveform into the capture path and collect ir_get_event() every POLL_US, as core1 does.
+ */
+static void replay(const ir_wave_t *w) {
+    event_count = 0;
+    uint64_t end = fake_now_us() + w->duration_us;
+    fake_ir_play(w->pulses, w->count);
+    while (fake_now_us() < end) {
+        fake_advance_us(POLL_US);
+        record(ir_get_event());
+    }
+}
+
+/**
+ * @brief Check the events of the last replay.
+ *
+ * @param expect  One letter per event: P press, H hold, R release.
+ */
+static void check_events(const char *expect) {
+    static const char letters[] = { [IR_EVENT_PRESS] = 'P', [IR_EVENT_HOLD] = 'H', [IR_EVENT_RELEASE] = 'R' };
+    char got[count_of(events) + 1];
+    for (size_t i = 0; i < event_count; i++) {
+        got[i] = letters[events[i].type];
+        CHECK_EQ(events[i].key, KEY);
+    }
+    got[event_count] = '\0';
+    if (strcmp(got, expect) != 0) printf("events %s, expected %s\n", got, expect);
+    CHECK(strcmp(got, expect) == 0);
+}
+
+/**
+ * @brief A held key with every repeat, with one lost, and with two in a row lost.
+ */
+static void test_lost_repeats(void) {
+    ir_wave_t w;
+    
+    // Every repeat arrives
+    hold_key(&w, 6, 0);
+    replay(&w);
+    check_events("PHHHHHHR");
+    
+    // One repeat lost: a 216ms gap, still held
+    hold_key(&w, 6, 1u << 3);
+    replay(&w);
+    check_events("PHHHHHR");
+    
+    // Two lost in a row: released, then pressed again by the next repeat
+    hold_key(&w, 6, 1u << 3 | 1u << 4);
+    replay(&w);
+    check_events("PHHRPHR");
+}
+
+/**
+ * @brief ir_track_key() on its own: a repeat after a release is a press of its command.
+ */
+static void test_repeat_after_release(void) {
+    ir_key_state_t ks = { -1, 0 };
+    ir_frame_t frame = { IR_PROTOCOL_NEC, 0x00, KEY, false };
+    ir_frame_t repeat = { IR_PROTOCOL_NEC, 0x00, KEY, true };
+    
+    CHECK_EQ(ir_track_key(&ks, &frame, 0).type, IR_EVENT_PRESS);
+    CHECK_EQ(ir_track_key(&ks, &repeat, REPEAT_US).type, IR_EVENT_HOLD);
+    CHECK_EQ(ir_track_key(&ks, NULL, REPEAT_US + IR_RELEASE_US).type, IR_EVENT_NONE);
+    CHECK_EQ(ir_track_key(&ks, NULL, REPEAT_US + IR_RELEASE_US + 1).type, IR_EVENT_RELEASE);
+    
+    ir_event_t ev = ir_track_key(&ks, &repeat, 4 * REPEAT_US);
+    CHECK_EQ(ev.type, IR_EVENT_PRESS);
+    CHECK_EQ(ev.key, KEY);
+    CHECK_EQ(ks.key, KEY);
+}
+
+int main(void) {
+    fake_reset();
+    ir_init();
+    test_lost_repeats();
+    test_repeat_after_release();
+    return CHECK_DONE();
+}
@@ -0,0 +1,267 @@
+/**
+ * @file test_ir_protocols.c
+ * @brief Decode synthetic NEC, SIRC, RC5 and RC5X waveforms with ir_decode_edge()
+ * @author Kevin Thomas
+ * @date 2025
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Kevin Thomas
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "check.h"
+#include "pico.h"
+#include "ir_wave.h"
+#include "ir.h"
+
+// Most frames one waveform decodes to
+#define MAX_FRAMES 8
+
+// Pulse and edge storage
+static fake_pulse_t pulses[1024];
+static uint32_t edges[1024];
+
+// Frames decoded by the last decode(), and the edge index each completed on
+static ir_frame_t frames[MAX_FRAMES];
+static size_t decoded;
+
+// Edge index at which the last decode() first counted an address reject, or -1
+static int address_reject_at;
+
+/**
+ * @brief Start a waveform.
+ *
+ * @param w      The waveform.
+ * @param scale  The remote's clock relative to nominal.
+ */
+static void wave(ir_wave_t *w, double scale) {
+    ir_wave_init(w, pulses, count_of(pulses), &(ir_wave_impair_t){ scale, 0, 0, 1 });
+}
+
+/**
+ * @brief Feed a waveform to a decoder, ending it with the gap ir_poll() would add.
+ *
+ * @param dec  The decoder.
+ * @param w    The waveform.
+ * @return size_t  The number of frames decoded.
+ */
+static size_t decode(ir_decoder_t *dec, const ir_wave_t *w) {
+    size_t n = ir_wave_edges(w, edges, count_of(edges) - 1);
+    edges[n++] = ~(uint32_t)IR_GAP_US;
+    
+    decoded = 0;
+    address_reject_at = -1;
+    uint32_t rejects = dec->stats.rejects[IR_REJECT_ADDRESS];
+    for (size_t i = 0; i < n; i++) {
+        ir_frame_t f;
+        if (ir_decode_edge(dec, edges[i], &f) && decoded < MAX_FRAMES) frames[decoded++] = f;
+        if (address_reject_at < 0 && dec->stats.rejects[IR_REJECT_ADDRESS] != rejects) address_reject_at = (int)i;
+    }
+    return decoded;
+}
+
+/**
+ * @brief Check a decoded frame.
+ */
+static void check_frame(size_t i, ir_protocol_t protocol, uint16_t address, uint8_t command, bool repeat) {
+    CHECK(i < decoded);
+    if (i >= decoded) return;
+    CHECK_EQ(frames[i].protocol, protocol);
+    CHECK_EQ(frames[i].address, address);
+    CHECK_EQ(frames[i].command, command);
+    CHECK_EQ(frames[i].repeat, repeat);
+}
+
+/**
+ * @brief NEC and extended NEC, at nominal and +-10% clock, with repeats and checksum errors.
+ */
+static void test_nec(void) {
+    static const double scales[] = { 1.0, 0.9, 1.1 };
+    ir_decoder_t dec;
+    ir_wave_t w;
+    
+    for (size_t s = 0; s < count_of(scales); s++) {
+        ir_decoder_reset(&dec);
+        wave(&w, scales[s]);
+        ir_wave_nec(&w, 0x04, 0x08);
+        CHECK_EQ(decode(&dec, &w), 1);
+        check_frame(0, IR_PROTOCOL_NEC, 0x04, 0x08, false);
+        
+        wave(&w, scales[s]);
+        ir_wave_nec_ext(&w, 0x1234, 0x55);
+        CHECK_EQ(decode(&dec, &w), 1);
+        check_frame(0, IR_PROTOCOL_NEC_EXT, 0x1234, 0x55, false);
+        
+        // A repeat code repeats the last full frame
+        wave(&w, scales[s]);
+        ir_wave_nec_repeat(&w);
+        CHECK_EQ(decode(&dec, &w), 1);
+        check_frame(0, IR_PROTOCOL_NEC_EXT, 0x1234, 0x55, true);
+        CHECK_EQ(dec.stats.rejects[IR_REJECT_TIMING], 0);
+    }
+    
+    // A repeat with nothing to repeat is rejected
+    ir_decoder_reset(&dec);
+    wave(&w, 1.0);
+    ir_wave_nec_repeat(&w);
+    CHECK_EQ(decode(&dec, &w), 0);
+    CHECK_EQ(dec.stats.rejects[IR_REJECT_REPEAT], 1);
+    
+    // Command and inverted command disagree
+    wave(&w, 1.0);
+    ir_wave_nec_raw(&w, 0x04 | 0xFBu << 8 | 0x08u << 16 | 0xF6u << 24);
+    CHECK_EQ(decode(&dec, &w), 0);
+    CHECK_EQ(dec.stats.rejects[IR_REJECT_CHECKSUM], 1);
+}
+
+/**
+ * @brief RC5 and RC5X, with the toggle bit telling presses from repeats.
+ */
+static void test_rc5(void) {
+    ir_decoder_t dec;
+    ir_decoder_reset(&dec);
+    ir_wave_t w;
+    
+    wave(&w, 1.0);
+    ir_wave_rc5(&w, 0x15, 0x22, false);
+    CHECK_EQ(decode(&dec, &w), 1);
+    check_frame(0, IR_PROTOCOL_RC5, 0x15, 0x22, false);
+    
+    // Same toggle and command again is the key held
+    wave(&w, 1.0);
+    ir_wave_rc5(&w, 0x15, 0x22, false);
+    CHECK_EQ(decode(&dec, &w), 1);
+    check_frame(0, IR_PROTOCOL_RC5, 0x15, 0x22, true);
+    
+    // Toggle flipped is a new press
+    wave(&w, 1.1);
+    ir_wave_rc5(&w, 0x15, 0x22, true);
+    CHECK_EQ(decode(&dec, &w), 1);
+    check_frame(0, IR_PROTOCOL_RC5, 0x15, 0x22, false);
+    
+    // RC5X: command bit 6 sent as an inverted second start bit
+    wave(&w, 0.9);
+    ir_wave_rc5(&w, 0x03, 0x62, false);
+    CHECK_EQ(decode(&dec, &w), 1);
+    check_frame(0, IR_PROTOCOL_RC5, 0x03, 0x62, false);
+    
+    // Every address and command bit in both values
+    wave(&w, 1.0);
+    ir_wave_rc5(&w, 0x1F, 0x7F, true);
+    CHECK_EQ(decode(&dec, &w), 1);
+    check_frame(0, IR_PROTOCOL_RC5, 0x1F, 0x7F, false);
+    wave(&w, 1.0);
+    ir_wave_rc5(&w, 0x00, 0x00, false);
+    CHECK_EQ(decode(&dec, &w), 1);
+    check_frame(0, IR_PROTOCOL_RC5, 0x00, 0x00, false);
+    CHECK_EQ(dec.stats.rejects[IR_REJECT_TIMING], 0);
+}
+
+/**
+ * @brief Sony SIRC in its 12, 15 and 20-bit lengths.
+ */
+static void test_sirc(void) {
+    static const struct { int bits; uint16_t address; double scale; } variants[] = {
+        { 12, 0x01, 1.0 }, { 12, 0x1F, 1.1 }, { 15, 0xA5, 1.0 }, { 15, 0xFF, 0.9 }, { 20, 0x1A5A, 1.0 }, { 20, 0x1FFF, 1.1 },
+    };
+    ir_decoder_t dec;
+    ir_decoder_reset(&dec);
+    ir_wave_t w;
+    
+    for (size_t i = 0; i < count_of(variants); i++) {
+        wave(&w, variants[i].scale);
+        ir_wave_sirc(&w, 0x55, variants[i].address, variants[i].bits);
+        CHECK_EQ(decode(&dec, &w), 1);
+        check_frame(0, IR_PROTOCOL_SIRC, variants[i].address, 0x55, false);
+    }
+    CHECK_EQ(dec.stats.rejects[IR_REJECT_LENGTH], 0);
+}
+
+/**
+ * @brief The address filter drops NEC and RC5 frames as soon as their address is in.
+ */
+static void test_filter(void) {
+    ir_decoder_t dec;
+    ir_wave_t w;
+    
+    // NEC for another robot: dropped once the 16 address bits are in, not at the end
+    ir_decoder_reset(&dec);
+    ir_decoder_set_filter(&dec, IR_PROTOCOL_NEC, 0x04);
+    wave(&w, 1.0);
+    ir_wave_nec(&w, 0x05, 0x08);
+    CHECK_EQ(decode(&dec, &w), 0);
+    CHECK_EQ(dec.stats.rejects[IR_REJECT_ADDRESS], 1);
+    CHECK(address_reject_at > 0 && address_reject_at <= 2 + 2 * 16 + 1);
+    
+    // The right address passes
+    wave(&w, 1.0);
+    ir_wave_nec(&w, 0x04, 0x08);
+    CHECK_EQ(decode(&dec, &w), 1);
+    check_frame(0, IR_PROTOCOL_NEC, 0x04, 0x08, false);
+    
+    // Extended NEC is another protocol to the filter
+    wave(&w, 1.0);
+    ir_wave_nec_ext(&w, 0x0004, 0x08);
+    CHECK_EQ(decode(&dec, &w), 0);
+    CHECK(address_reject_at > 0 && address_reject_at <= 2 + 2 * 16 + 1);
+    
+    // Other protocols are not decoded at all
+    wave(&w, 1.0);
+    ir_wave_rc5(&w, 0x04, 0x08, false);
+    ir_wave_idle(&w, 20000);
+    ir_wave_sirc(&w, 0x08, 0x04, 12);
+    CHECK_EQ(decode(&dec, &w), 0);
+    CHECK_EQ(address_reject_at, -1);
+    
+    // RC5 for another robot: dropped after 8 of its 14 bits (about 16 half-bit pulses in)
+    ir_decoder_reset(&dec);
+    ir_decoder_set_filter(&dec, IR_PROTOCOL_RC5, 0x15);
+    wave(&w, 1.0);
+    ir_wave_rc5(&w, 0x14, 0x22, false);
+    size_t pulses_in_frame = w.count;
+    CHECK_EQ(decode(&dec, &w), 0);
+    CHECK_EQ(dec.stats.rejects[IR_REJECT_ADDRESS], 1);
+    CHECK(address_reject_at > 0 && (size_t)address_reject_at < pulses_in_frame - 4);
+    
+    wave(&w, 1.0);
+    ir_wave_rc5(&w, 0x15, 0x22, false);
+    CHECK_EQ(decode(&dec, &w), 1);
+    check_frame(0, IR_PROTOCOL_RC5, 0x15, 0x22, false);
+    
+    // SIRC sends its address last, so it can only be dropped at the end
+    ir_decoder_reset(&dec);
+    ir_decoder_set_filter(&dec, IR_PROTOCOL_SIRC, 0x01);
+    wave(&w, 1.0);
+    ir_wave_sirc(&w, 0x08, 0x02, 12);
+    CHECK_EQ(decode(&dec, &w), 0);
+    CHECK_EQ(dec.stats.rejects[IR_REJECT_ADDRESS], 1);
+    wave(&w, 1.0);
+    ir_wave_sirc(&w, 0x08, 0x01, 12);
+    CHECK_EQ(decode(&dec, &w), 1);
+}
+
+int main(void) {
+    test_nec();
+    test_rc5();
+    test_sirc();
+    test_filter();
+    return CHECK_DONE();
+}
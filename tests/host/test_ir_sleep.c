@@ -0,0 +1,103 @@
+/**
+ * @file test_ir_sleep.c
+ * @brief Core1 sleep until an IR edge: wake-up with no other core to send events
+ * @author Kevin Thomas
+ * @date 2025
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Kevin Thomas
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "check.h"
+#include "pico.h"
+#include "fake_sdk.h"
+#include "ir_wave.h"
+#include "ir.h"
+
+// Idle line before the frame starts
+#define LEAD_IN_US 5000
+
+// NEC leader mark, the first pulse DMA captures
+#define LEADER_US 9000
+
+// How often core1 polls for key events once awake
+#define POLL_US 1000
+
+// Pulse storage
+static fake_pulse_t pulses[256];
+
+/**
+ * @brief Sleep, then poll key events as core1 does until the press; no alarm or timer runs.
+ */
+static void test_wake(void) {
+    fake_reset();
+    ir_init();
+    ir_sleep_init();
+    
+    ir_wave_t w;
+    ir_wave_init(&w, pulses, count_of(pulses), NULL);
+    ir_wave_idle(&w, LEAD_IN_US);
+    ir_wave_nec(&w, 0x00, 0x18);
+    ir_wave_idle(&w, 2 * IR_RELEASE_US);
+    fake_ir_play(w.pulses, w.count);
+    
+    // Woken by the IR edges alone, as soon as the leader has been captured
+    CHECK(ir_sleep());
+    CHECK_EQ(fake_now_us(), LEAD_IN_US + LEADER_US);
+    ir_sleep_stats_t st;
+    ir_get_sleep_stats(&st);
+    CHECK_EQ(st.sleeps, 1);
+    CHECK(st.wake_max_us <= POLL_US);
+    
+    // Decoded the moment the frame ends, not when something else happens to wake the core
+    ir_event_t ev;
+    do {
+        fake_advance_us(POLL_US);
+        ev = ir_get_event();
+    } while (ev.type == IR_EVENT_NONE && fake_now_us() < w.duration_us);
+    CHECK_EQ(ev.type, IR_EVENT_PRESS);
+    ir_get_sleep_stats(&st);
+    CHECK(st.decode_last_us <= w.duration_us - 2 * IR_RELEASE_US - LEAD_IN_US + POLL_US);
+    
+    // Awake while the key is held
+    CHECK(!ir_sleep());
+    while (ir_get_event().type != IR_EVENT_RELEASE)
+        fake_advance_us(POLL_US);
+    
+    // Once released, asleep again; capture is running now, so the leader's falling edge
+    // ends the idle pulse and wakes the core at once
+    ir_wave_init(&w, pulses, count_of(pulses), NULL);
+    ir_wave_idle(&w, LEAD_IN_US);
+    ir_wave_nec(&w, 0x00, 0x08);
+    fake_advance_us(2 * IR_RELEASE_US);
+    uint64_t start = fake_now_us();
+    fake_ir_play(w.pulses, w.count);
+    CHECK(ir_sleep());
+    CHECK_EQ(fake_now_us() - start, LEAD_IN_US);
+    ir_get_sleep_stats(&st);
+    CHECK_EQ(st.sleeps, 2);
+}
+
+int main(void) {
+    test_wake();
+    return CHECK_DONE();
+}
@@ -0,0 +1,126 @@
+/**
+ * @file test_ir_traces.c
+ * @brief Replay the NEC trace fixtures through ir_decode_edge() and check the frames
+ * @author Kevin Thomas
+ * @date 2025
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Kevin Thomas
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "check.h"
+#include "ir.h"
+
+// Most frames one trace may expect
+#define TRACE_MAX_FRAMES 256
+
+/**
+ * @brief A frame as written in a "# expect" line.
+ */
+typedef struct {
+    char protocol[16];
+    unsigned int address;
+    unsigned int command;
+    bool repeat;
+} trace_frame_t;
+
+// Protocol names, as written in "# expect" lines
+static const char *const trace_protocols[] = {
+    [IR_PROTOCOL_NONE]    = "none",
+    [IR_PROTOCOL_NEC]     = "nec",
+    [IR_PROTOCOL_NEC_EXT] = "nec-ext",
+    [IR_PROTOCOL_RC5]     = "rc5",
+    [IR_PROTOCOL_SIRC]    = "sirc",
+};
+
+/**
+ * @brief Replay one trace file and check it decodes to its expected frames.
+ *
+ * @param path  The trace file.
+ */
+static void test_trace(const char *path) {
+    static trace_frame_t expect[TRACE_MAX_FRAMES];
+    size_t expected = 0, decoded = 0;
+    FILE *f = fopen(path, "r");
+    CHECK(f != NULL);
+    if (!f) return;
+    
+    ir_decoder_t dec;
+    ir_decoder_reset(&dec);
+    uint32_t last_edge_us = 0;
+    char line[80];
+    
+    while (fgets(line, sizeof(line), f)) {
+        unsigned long time_us, value;
+        ir_frame_t frame;
+        bool done = false;
+        
+        // Expected frames come first
+        trace_frame_t *e = &expect[expected];
+        char repeat[8] = "";
+        if (expected < TRACE_MAX_FRAMES &&
+            sscanf(line, "# expect %15s %x %x %7s", e->protocol, &e->address, &e->command, repeat) >= 3) {
+            e->repeat = strcmp(repeat, "repeat") == 0;
+            expected++;
+            continue;
+        }
+        if (sscanf(line, "E %lu %lx", &time_us, &value) != 2) continue;
+        
+        // End a frame followed by silence, as ir_poll() does on the robot
+        if (!ir_decoder_idle(&dec) && (uint32_t)time_us - last_edge_us >= IR_GAP_US)
+            done = ir_decode_edge(&dec, ~(uint32_t)IR_GAP_US, &frame);
+        if (!done) done = ir_decode_edge(&dec, (uint32_t)value, &frame);
+        last_edge_us = (uint32_t)time_us;
+        
+        // Every frame decoded must be the next one expected
+        if (done) {
+            CHECK(decoded < expected);
+            if (decoded < expected) {
+                e = &expect[decoded];
+                CHECK(strcmp(trace_protocols[frame.protocol], e->protocol) == 0);
+                CHECK_EQ(frame.address, e->address);
+                CHECK_EQ(frame.command, e->command);
+                CHECK_EQ(frame.repeat, e->repeat);
+            }
+            decoded++;
+        }
+    }
+    fclose(f);
+    
+    // The last frame is only ended by the silence after it
+    ir_frame_t frame;
+    if (!ir_decoder_idle(&dec) && ir_decode_edge(&dec, ~(uint32_t)IR_GAP_US, &frame)) decoded++;
+    
+    printf("%s: %zu/%zu frames, %lu glitches\n", path, decoded, expected, (unsigned long)dec.stats.glitches);
+    CHECK(expected > 0);
+    CHECK_EQ(decoded, expected);
+    CHECK_EQ(dec.stats.rejects[IR_REJECT_CHECKSUM], 0);
+    CHECK_EQ(dec.stats.rejects[IR_REJECT_REPEAT], 0);
+}
+
+int main(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) test_trace(argv[i]);
+    CHECK(argc > 1);
+    return CHECK_DONE();
+}
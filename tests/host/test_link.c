@@ -0,0 +1,208 @@
+/**
+ * @file test_link.c
+ * @brief Check link_poll() framing: resync after lost delimiters and text only as whole lines
+ * @author Kevin Thomas
+ * @date 2025
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Kevin Thomas
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <string.h>
+#include "check.h"
+#include "fake_sdk.h"
+#include "link.h"
+#include "control.h"
+#include "robot.h"
+
+// Text handed to the handler since the last take_text()
+static char text_buf[256];
+static size_t text_len;
+
+/**
+ * @brief Text handler collecting into text_buf.
+ */
+static void on_text(int c) {
+    if (text_len < sizeof(text_buf) - 1) text_buf[text_len++] = (char)c;
+    text_buf[text_len] = '\0';
+}
+
+/**
+ * @brief Take the text received so far.
+ */
+static const char *take_text(void) {
+    static char taken[sizeof(text_buf)];
+    memcpy(taken, text_buf, text_len + 1);
+    text_len = 0;
+    text_buf[0] = '\0';
+    return taken;
+}
+
+/**
+ * @brief Build a wire frame: delimiter, COBS of header, body and CRC, delimiter.
+ *
+ * @return size_t  Number of bytes written to wire.
+ */
+static size_t build_frame(uint8_t type, const uint8_t *body, size_t len, uint8_t *wire) {
+    uint8_t frame[LINK_FRAME_MAX];
+    frame[0] = type;
+    frame[1] = 0;
+    memcpy(&frame[2], body, len);
+    uint16_t crc = link_crc16(frame, 2 + len);
+    frame[2 + len] = (uint8_t)crc;
+    frame[3 + len] = (uint8_t)(crc >> 8);
+    wire[0] = 0;
+    size_t n = link_cobs_encode(frame, len + 4, &wire[1]) + 1;
+    wire[n++] = 0;
+    return n;
+}
+
+/**
+ * @brief Feed bytes to link_poll() until they have all been taken.
+ */
+static void feed(const void *data, size_t len) {
+    fake_usb_input(data, len);
+    for (size_t i = 0; i <= len / LINK_RX_CHUNK; i++) link_poll(on_text);
+}
+
+/**
+ * @brief Ask for telemetry and read the frame and error counters from the reply.
+ */
+static void counters(uint16_t *frames, uint16_t *errors) {
+    uint8_t wire[LINK_WIRE_MAX];
+    feed(wire, build_frame(LINK_MSG_TELEMETRY, NULL, 0, wire));
+    
+    // Reply is 0x00, COBS of 17 bytes, 0x00
+    uint8_t out[64];
+    size_t n = fake_usb_output(out, sizeof(out));
+    CHECK(n > 2 && out[0] == 0 && out[n - 1] == 0);
+    int len = link_cobs_decode(&out[1], n - 2);
+    CHECK_EQ(len, 17);
+    CHECK_EQ(out[1], LINK_REPLY_TELEMETRY);
+    *frames = (uint16_t)(out[1 + 11] | out[1 + 12] << 8);
+    *errors = (uint16_t)(out[1 + 13] | out[1 + 14] << 8);
+}
+
+/**
+ * @brief Frames and errors counted by link_poll() while feeding data.
+ */
+static void feed_counted(const void *data, size_t len, int frames, int errors) {
+    uint16_t f0, e0, f1, e1;
+    counters(&f0, &e0);
+    feed(data, len);
+    counters(&f1, &e1);
+    
+    // The first telemetry request counts itself
+    CHECK_EQ((uint16_t)(f1 - f0), frames + 1);
+    CHECK_EQ((uint16_t)(e1 - e0), errors);
+}
+
+/**
+ * @brief Text lines between frames reach the handler whole; a partial line waits for its end.
+ */
+static void test_text_lines(void) {
+    uint8_t data[128], hb[LINK_WIRE_MAX];
+    size_t hb_len = build_frame(LINK_MSG_HEARTBEAT, NULL, 0, hb);
+    size_t n = 0;
+    memcpy(&data[n], "s\n", 2); n += 2;
+    memcpy(&data[n], hb, hb_len); n += hb_len;
+    memcpy(&data[n], "m 1 2 3\r", 8); n += 8;
+    memcpy(&data[n], hb, hb_len); n += hb_len;
+    feed_counted(data, n, 2, 0);
+    CHECK(strcmp(take_text(), "s\nm 1 2 3\r") == 0);
+    
+    // Nothing until the line ends
+    feed("t", 1);
+    CHECK(strcmp(take_text(), "") == 0);
+    feed("\n", 1);
+    CHECK(strcmp(take_text(), "t\n") == 0);
+}
+
+/**
+ * @brief A lost opening or closing delimiter costs no frame.
+ */
+static void test_lost_delimiters(void) {
+    uint8_t data[128], hb[LINK_WIRE_MAX];
+    size_t hb_len = build_frame(LINK_MSG_HEARTBEAT, NULL, 0, hb);
+    
+    // Closing delimiter lost: the next frame's opening one ends it
+    size_t n = 0;
+    memcpy(&data[n], hb, hb_len - 1); n += hb_len - 1;
+    memcpy(&data[n], hb, hb_len); n += hb_len;
+    memcpy(&data[n], "s\n", 2); n += 2;
+    feed_counted(data, n, 2, 0);
+    CHECK(strcmp(take_text(), "s\n") == 0);
+    
+    // Opening delimiter lost: its frame still ends at the closing one
+    n = 0;
+    memcpy(&data[n], &hb[1], hb_len - 1); n += hb_len - 1;
+    memcpy(&data[n], hb, hb_len); n += hb_len;
+    memcpy(&data[n], "s\n", 2); n += 2;
+    feed_counted(data, n, 2, 0);
+    CHECK(strcmp(take_text(), "s\n") == 0);
+}
+
+/**
+ * @brief Binary noise, lines after a stray opening delimiter and overlong lines never reach the handler.
+ */
+static void test_not_text(void) {
+    uint8_t data[160], hb[LINK_WIRE_MAX];
+    size_t hb_len = build_frame(LINK_MSG_HEARTBEAT, NULL, 0, hb);
+    
+    // Noise with a newline in it, ended by the next frame
+    static const uint8_t noise[] = { 0x03, 0x81, '\n', 0x7F };
+    size_t n = 0;
+    memcpy(&data[n], noise, sizeof(noise)); n += sizeof(noise);
+    memcpy(&data[n], hb, hb_len); n += hb_len;
+    feed_counted(data, n, 1, 1);
+    CHECK(strcmp(take_text(), "") == 0);
+    
+    // A line right after an opening delimiter is taken as a frame
+    n = 0;
+    data[n++] = 0;
+    memcpy(&data[n], "s\n", 2); n += 2;
+    memcpy(&data[n], hb, hb_len); n += hb_len;
+    feed_counted(data, n, 1, 1);
+    CHECK(strcmp(take_text(), "") == 0);
+    
+    // A line longer than the receive buffer is dropped, the next one gets through
+    memset(data, 'a', LINK_RX_MAX + 10);
+    n = LINK_RX_MAX + 10;
+    memcpy(&data[n], "\ns\n", 3); n += 3;
+    feed_counted(data, n, 0, 1);
+    CHECK(strcmp(take_text(), "s\n") == 0);
+}
+
+int main(void) {
+    fake_reset();
+    motor_init();
+    control_init(NULL);
+    
+    // Sync the receiver with a frame before the tests
+    uint8_t hb[LINK_WIRE_MAX];
+    feed(hb, build_frame(LINK_MSG_HEARTBEAT, NULL, 0, hb));
+    
+    test_text_lines();
+    test_lost_delimiters();
+    test_not_text();
+    return CHECK_DONE();
+}
@@ -0,0 +1,135 @@
+/**
+ * @file test_log_ring.c
+ * @brief Check log_drain() only prints when the USB CDC buffer has room for the line
+ * @author Kevin Thomas
+ * @date 2025
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Kevin Thomas
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <string.h>
+#include <unistd.h>
+#include "check.h"
+#include "fake_sdk.h"
+#include "log_ring.h"
+
+// Text printed by the last capture_drain()
+static char captured[4096];
+
+/**
+ * @brief Run log_drain() with stdout redirected into captured.
+ *
+ * @return size_t  The number of lines printed.
+ */
+static size_t capture_drain(void) {
+    FILE *tmp = tmpfile();
+    fflush(stdout);
+    int saved = dup(STDOUT_FILENO);
+    dup2(fileno(tmp), STDOUT_FILENO);
+    
+    log_drain();
+    
+    fflush(stdout);
+    dup2(saved, STDOUT_FILENO);
+    close(saved);
+    rewind(tmp);
+    size_t n = fread(captured, 1, sizeof(captured) - 1, tmp);
+    captured[n] = '\0';
+    fclose(tmp);
+    
+    size_t lines = 0;
+    for (char *p = captured; (p = strchr(p, '\n')); p++) lines++;
+    return lines;
+}
+
+/**
+ * @brief Nothing is printed or consumed without a host or without room.
+ */
+static void test_no_room(void) {
+    fake_reset();
+    fake_advance_us(1234);
+    log_event(LOG_SPEED, 42);
+    
+    // No host: nothing printed
+    fake_usb_set(false, 1024);
+    CHECK_EQ(capture_drain(), 0);
+    
+    // Host connected but its buffer full (DTR set, nobody reading)
+    fake_usb_set(true, 0);
+    CHECK_EQ(capture_drain(), 0);
+    
+    // One byte short of the line plus CR
+    fake_usb_set(true, (uint32_t)strlen("[      1234] speed: 42\n"));
+    CHECK_EQ(capture_drain(), 0);
+    
+    // Room for it: the record was kept and comes out whole
+    fake_usb_set(true, (uint32_t)strlen("[      1234] speed: 42\n") + 1);
+    CHECK_EQ(capture_drain(), 1);
+    CHECK(strcmp(captured, "[      1234] speed: 42\n") == 0);
+    
+    // And only once
+    fake_usb_set(true, 1024);
+    CHECK_EQ(capture_drain(), 0);
+    CHECK_EQ(log_dropped(), 0);
+}
+
+/**
+ * @brief At most LOG_DRAIN_MAX records per call, in order.
+ */
+static void test_batches(void) {
+    for (uint32_t i = 0; i < 6; i++) log_event(LOG_MACRO, i);
+    fake_usb_set(true, 1024);
+    CHECK_EQ(capture_drain(), LOG_DRAIN_MAX);
+    CHECK(strstr(captured, "macro: 0\n") != NULL);
+    CHECK(strstr(captured, "macro: 3\n") != NULL);
+    CHECK(strstr(captured, "macro: 4\n") == NULL);
+    CHECK_EQ(capture_drain(), 2);
+    CHECK(strstr(captured, "macro: 4\n") < strstr(captured, "macro: 5\n"));
+}
+
+/**
+ * @brief Drops are counted while full and reported once the backlog has been printed.
+ */
+static void test_drops(void) {
+    for (uint32_t i = 0; i < LOG_RING_SIZE + 3; i++) log_event(LOG_RELEASE, 0);
+    CHECK_EQ(log_dropped(), 3);
+    
+    // The report waits for room like any other line
+    size_t lines = 0;
+    fake_usb_set(true, 1024);
+    for (int i = 0; i < LOG_RING_SIZE / LOG_DRAIN_MAX; i++) lines += capture_drain();
+    CHECK_EQ(lines, LOG_RING_SIZE);
+    fake_usb_set(true, 0);
+    CHECK_EQ(capture_drain(), 0);
+    fake_usb_set(true, 1024);
+    CHECK_EQ(capture_drain(), 1);
+    CHECK(strcmp(captured, "log: 3 dropped\n") == 0);
+    CHECK_EQ(capture_drain(), 0);
+}
+
+int main(void) {
+    test_no_room();
+    test_batches();
+    test_drops();
+    return CHECK_DONE();
+}
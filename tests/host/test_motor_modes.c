@@ -0,0 +1,202 @@
+/**
+ * @file test_motor_modes.c
+ * @brief Check the H-bridge pin levels and pin functions of every motor mode
+ * @author Kevin Thomas
+ * @date 2025
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Kevin Thomas
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "check.h"
+#include "fake_sdk.h"
+#include "robot.h"
+#include "hardware/gpio.h"
+
+// Motor pins, for snapshots of their PWM levels
+static const uint32_t motor_pins[] = { PWMA, AIN2, AIN1, BIN1, BIN2, PWMB };
+
+// PWM levels of the motor pins when the write log was last cleared
+static uint16_t start_levels[6];
+
+/**
+ * @brief Clear the write log and remember the PWM levels it starts from.
+ */
+static void mark(void) {
+    for (int i = 0; i < 6; i++) start_levels[i] = fake_pwm_level(motor_pins[i]);
+    fake_clear_writes();
+}
+
+/**
+ * @brief Replay the write log and check no pin was handed to PWM with a non-zero level.
+ */
+static void check_reroute_safe(void) {
+    uint16_t levels[6];
+    for (int i = 0; i < 6; i++) levels[i] = start_levels[i];
+    
+    for (uint32_t i = 0; i < fake_log_count && i < FAKE_LOG_SIZE; i++) {
+        for (int p = 0; p < 6; p++) {
+            if (fake_log[i].op == FAKE_PWM_LEVEL && fake_log[i].a == FAKE_PWM_CHAN(motor_pins[p]))
+                levels[p] = (uint16_t)fake_log[i].b;
+            if (fake_log[i].op == FAKE_GPIO_FUNCTION && fake_log[i].a == motor_pins[p] &&
+                fake_log[i].b == GPIO_FUNC_PWM)
+                CHECK_EQ(levels[p], 0);
+        }
+    }
+}
+
+/**
+ * @brief Find a write in the log.
+ *
+ * @param op  The operation.
+ * @param a   Its first argument.
+ * @param b   Its second argument.
+ * @return int  Index of the first match, or -1.
+ */
+static int find_write(fake_op_t op, uint32_t a, uint32_t b) {
+    for (uint32_t i = 0; i < fake_log_count && i < FAKE_LOG_SIZE; i++)
+        if (fake_log[i].op == op && fake_log[i].a == a && fake_log[i].b == b) return (int)i;
+    return -1;
+}
+
+/**
+ * @brief Check the four input pins are SIO outputs at the given levels.
+ */
+static void check_inputs(bool ain1, bool ain2, bool bin1, bool bin2) {
+    CHECK_EQ(fake_gpio_function(AIN1), GPIO_FUNC_SIO);
+    CHECK_EQ(fake_gpio_function(AIN2), GPIO_FUNC_SIO);
+    CHECK_EQ(fake_gpio_function(BIN1), GPIO_FUNC_SIO);
+    CHECK_EQ(fake_gpio_function(BIN2), GPIO_FUNC_SIO);
+    CHECK_EQ(fake_gpio_out(AIN1), ain1);
+    CHECK_EQ(fake_gpio_out(AIN2), ain2);
+    CHECK_EQ(fake_gpio_out(BIN1), bin1);
+    CHECK_EQ(fake_gpio_out(BIN2), bin2);
+}
+
+/**
+ * @brief Slow decay: inputs fixed by direction, PWMA/PWMB carry the duty.
+ */
+static void test_slow_decay(void) {
+    fake_reset();
+    motor_init();
+    
+    motor_forward(30000);
+    check_inputs(false, true, false, true);
+    CHECK_EQ(fake_gpio_function(PWMA), GPIO_FUNC_PWM);
+    CHECK_EQ(fake_gpio_function(PWMB), GPIO_FUNC_PWM);
+    CHECK(fake_pwm_level(PWMA) > 0);
+    CHECK(fake_pwm_level(PWMB) > 0);
+    
+    motor_backward(30000);
+    check_inputs(true, false, true, false);
+    CHECK(fake_pwm_level(PWMA) > 0);
+}
+
+/**
+ * @brief Brake drives all four inputs high with no duty; coast drives them all low.
+ */
+static void test_brake_coast(void) {
+    fake_reset();
+    motor_init();
+    motor_forward(30000);
+    
+    motor_brake();
+    check_inputs(true, true, true, true);
+    CHECK_EQ(fake_pwm_level(PWMA), 0);
+    CHECK_EQ(fake_pwm_level(PWMB), 0);
+    
+    motor_stop();
+    check_inputs(false, false, false, false);
+    CHECK_EQ(fake_pwm_level(PWMA), 0);
+    CHECK_EQ(fake_pwm_level(PWMB), 0);
+}
+
+/**
+ * @brief Fast decay: PWMx held high, the active input routed to PWM, rerouted at zero duty.
+ */
+static void test_fast_decay(void) {
+    fake_reset();
+    motor_init();
+    motor_forward(30000);
+    
+    // Switching mode coasts first, then hands PWMA/PWMB back to SIO, still high
+    mark();
+    motor_set_decay(MOTOR_DECAY_FAST);
+    CHECK_EQ(fake_pwm_level(PWMA), 0);
+    CHECK_EQ(fake_pwm_level(PWMB), 0);
+    CHECK_EQ(fake_gpio_function(PWMA), GPIO_FUNC_SIO);
+    CHECK_EQ(fake_gpio_function(PWMB), GPIO_FUNC_SIO);
+    CHECK(fake_gpio_out(PWMA));
+    CHECK(fake_gpio_out(PWMB));
+    check_inputs(false, false, false, false);
+    
+    // Forward: AIN2/BIN2 carry the duty, AIN1/BIN1 low
+    mark();
+    motor_forward(30000);
+    check_reroute_safe();
+    CHECK_EQ(fake_gpio_function(AIN2), GPIO_FUNC_PWM);
+    CHECK_EQ(fake_gpio_function(BIN2), GPIO_FUNC_PWM);
+    CHECK_EQ(fake_gpio_function(AIN1), GPIO_FUNC_SIO);
+    CHECK_EQ(fake_gpio_function(BIN1), GPIO_FUNC_SIO);
+    CHECK(!fake_gpio_out(AIN1));
+    CHECK(!fake_gpio_out(BIN1));
+    CHECK(fake_pwm_level(AIN2) > 0);
+    CHECK(fake_pwm_level(BIN2) > 0);
+    CHECK(fake_gpio_out(PWMA));
+    
+    // Reverse: old inputs leave PWM only after their duty is 0, new ones enter at 0
+    mark();
+    motor_backward(30000);
+    check_reroute_safe();
+    int zero = find_write(FAKE_PWM_LEVEL, FAKE_PWM_CHAN(AIN2), 0);
+    int leave = find_write(FAKE_GPIO_FUNCTION, AIN2, GPIO_FUNC_SIO);
+    int enter = find_write(FAKE_GPIO_FUNCTION, AIN1, GPIO_FUNC_PWM);
+    CHECK(zero >= 0 && leave > zero);
+    CHECK(enter > leave);
+    CHECK_EQ(fake_gpio_function(AIN1), GPIO_FUNC_PWM);
+    CHECK_EQ(fake_gpio_function(BIN1), GPIO_FUNC_PWM);
+    CHECK_EQ(fake_gpio_function(AIN2), GPIO_FUNC_SIO);
+    CHECK_EQ(fake_gpio_function(BIN2), GPIO_FUNC_SIO);
+    CHECK(!fake_gpio_out(AIN2));
+    CHECK(fake_pwm_level(AIN1) > 0);
+    
+    // Brake in fast decay: every input back on SIO and high
+    mark();
+    motor_brake();
+    check_reroute_safe();
+    check_inputs(true, true, true, true);
+    
+    // Back to slow decay: PWMA/PWMB carry the duty again
+    motor_set_decay(MOTOR_DECAY_SLOW);
+    motor_forward(30000);
+    CHECK_EQ(fake_gpio_function(PWMA), GPIO_FUNC_PWM);
+    CHECK_EQ(fake_gpio_function(PWMB), GPIO_FUNC_PWM);
+    check_inputs(false, true, false, true);
+    CHECK(fake_pwm_level(PWMA) > 0);
+}
+
+int main(void) {
+    test_slow_decay();
+    test_brake_coast();
+    test_fast_decay();
+    return CHECK_DONE();
+}
@@ -0,0 +1,173 @@
+/**
+ * @file test_motor_writes.c
+ * @brief Check the motor output layer only writes the registers that change, in a safe order
+ * @author Kevin Thomas
+ * @date 2025
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Kevin Thomas
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "check.h"
+#include "fake_sdk.h"
+#include "robot.h"
+#include "hardware/clocks.h"
+#include "hardware/gpio.h"
+
+// Direction pin patterns as robot.c drives them
+#define DIR_MASK     ((1u << AIN1) | (1u << AIN2) | (1u << BIN1) | (1u << BIN2))
+#define DIR_FORWARD  ((1u << AIN2) | (1u << BIN2))
+#define DIR_BACKWARD ((1u << AIN1) | (1u << BIN1))
+
+/**
+ * @brief Check a compare level is the duty rescaled to the PWM wrap, within one count.
+ *
+ * @param level  The level written.
+ * @param duty   The duty (0-65535) asked for.
+ */
+static void check_level(uint32_t level, uint32_t duty) {
+    uint32_t top = SYS_CLK_HZ / MOTOR_PWM_HZ - 1;
+    uint32_t want = (duty * top + 32767) / 65535;
+    CHECK(level + 1 >= want && level <= want + 1);
+}
+
+/**
+ * @brief Check one logged write.
+ *
+ * @param i   Index in the write log.
+ * @param op  Expected operation.
+ * @param a   Expected first argument.
+ */
+static void check_write(uint32_t i, fake_op_t op, uint32_t a) {
+    CHECK(i < fake_log_count);
+    if (i >= fake_log_count) return;
+    CHECK_EQ(fake_log[i].op, op);
+    CHECK_EQ(fake_log[i].a, a);
+}
+
+/**
+ * @brief Start from a freshly initialised driver with nothing logged.
+ */
+static void motor_setup(void) {
+    fake_reset();
+    motor_init();
+    fake_clear_writes();
+}
+
+/**
+ * @brief Starting from stop: direction once, then each duty once.
+ */
+static void test_start(void) {
+    motor_setup();
+    motor_forward(30000);
+    
+    CHECK_EQ(fake_calls.gpio_put_masked, 1);
+    CHECK_EQ(fake_calls.pwm_set_chan_level, 2);
+    CHECK_EQ(fake_calls.gpio_set_function, 0);
+    CHECK_EQ(fake_calls.gpio_put, 0);
+    
+    // Direction before drive; the duties were already 0 so are not rewritten first
+    check_write(0, FAKE_GPIO_PUT_MASKED, DIR_MASK);
+    CHECK_EQ(fake_log[0].b, DIR_FORWARD);
+    check_write(1, FAKE_PWM_LEVEL, FAKE_PWM_CHAN(PWMA));
+    check_write(2, FAKE_PWM_LEVEL, FAKE_PWM_CHAN(PWMB));
+    check_level(fake_pwm_level(PWMA), 30000);
+    check_level(fake_pwm_level(PWMB), 30000);
+}
+
+/**
+ * @brief The same command again touches no hardware at all.
+ */
+static void test_repeat(void) {
+    motor_setup();
+    motor_forward(30000);
+    fake_clear_writes();
+    
+    for (int i = 0; i < 10; i++) motor_forward(30000);
+    motor_drive(30000, 30000);
+    CHECK_EQ(fake_log_count, 0);
+    CHECK_EQ(fake_calls.other, 0);
+    
+    // Braking or stopping twice is free the second time too
+    motor_brake();
+    fake_clear_writes();
+    motor_brake();
+    CHECK_EQ(fake_log_count, 0);
+    motor_stop();
+    fake_clear_writes();
+    motor_stop();
+    CHECK_EQ(fake_log_count, 0);
+}
+
+/**
+ * @brief A speed change in the same direction only writes compare registers.
+ */
+static void test_speed_change(void) {
+    motor_setup();
+    motor_forward(30000);
+    fake_clear_writes();
+    
+    motor_forward(40000);
+    CHECK_EQ(fake_calls.pwm_set_chan_level, 2);
+    CHECK_EQ(fake_calls.gpio_put_masked, 0);
+    CHECK_EQ(fake_calls.gpio_set_function, 0);
+    check_level(fake_pwm_level(PWMA), 40000);
+    check_level(fake_pwm_level(PWMB), 40000);
+    
+    // Changing one wheel writes only that wheel's register
+    fake_clear_writes();
+    motor_drive(40000, 20000);
+    CHECK_EQ(fake_log_count, 1);
+    check_write(0, FAKE_PWM_LEVEL, FAKE_PWM_CHAN(PWMB));
+    check_level(fake_pwm_level(PWMB), 20000);
+}
+
+/**
+ * @brief A direction change drops the duty, moves the pins, then restores the duty.
+ */
+static void test_direction_change(void) {
+    motor_setup();
+    motor_forward(40000);
+    fake_clear_writes();
+    
+    motor_backward(40000);
+    CHECK_EQ(fake_log_count, 5);
+    check_write(0, FAKE_PWM_LEVEL, FAKE_PWM_CHAN(PWMA));
+    CHECK_EQ(fake_log[0].b, 0);
+    check_write(1, FAKE_PWM_LEVEL, FAKE_PWM_CHAN(PWMB));
+    CHECK_EQ(fake_log[1].b, 0);
+    check_write(2, FAKE_GPIO_PUT_MASKED, DIR_MASK);
+    CHECK_EQ(fake_log[2].b, DIR_BACKWARD);
+    check_write(3, FAKE_PWM_LEVEL, FAKE_PWM_CHAN(PWMA));
+    check_write(4, FAKE_PWM_LEVEL, FAKE_PWM_CHAN(PWMB));
+    check_level(fake_pwm_level(PWMA), 40000);
+    check_level(fake_pwm_level(PWMB), 40000);
+    CHECK_EQ(fake_calls.gpio_set_function, 0);
+}
+
+int main(void) {
+    test_start();
+    test_repeat();
+    test_speed_change();
+    test_direction_change();
+    return CHECK_DONE();
+}
@@ -0,0 +1,259 @@
+/**
+ * @file test_sched.c
+ * @brief sched_run(), sched_account() and sched_release() on a virtual clock
+ * @author Kevin Thomas
+ * @date 2025
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Kevin Thomas
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <string.h>
+#include "pico.h"
+#include "check.h"
+#include "sched.h"
+
+// Start time of the order test, just before the 32-bit clock wraps
+#define WRAP_START_US 0xFFFFFC18u
+
+// A task table entry; sched_init() fills in the rest
+#define TASK(n, fn, period, deadline) { .name = n, .run = fn, .period_us = period, .deadline_us = deadline }
+
+// Virtual clock, moved by the test and by the tasks' run time
+static uint32_t clock_us;
+
+// Names of the tasks run, in order, since the last clear
+static char order[64];
+
+// Run time each task takes
+static uint32_t cost_a, cost_b, cost_c;
+
+/**
+ * @brief The scheduler's clock.
+ */
+static uint32_t clock_now(void) {
+    return clock_us;
+}
+
+/**
+ * @brief Log a run and use up its run time.
+ */
+static void ran(char name, uint32_t cost_us) {
+    size_t n = strlen(order);
+    if (n + 1 < sizeof(order)) order[n] = name;
+    clock_us += cost_us;
+}
+
+static void run_a(void) { ran('a', cost_a); }
+static void run_b(void) { ran('b', cost_b); }
+static void run_c(void) { ran('c', cost_c); }
+
+/**
+ * @brief Set the clock and clear the run log and run times.
+ */
+static void setup(uint32_t now_us) {
+    clock_us = now_us;
+    memset(order, 0, sizeof(order));
+    cost_a = cost_b = cost_c = 0;
+}
+
+/**
+ * @brief Check the tasks run since the last call, then clear the log.
+ */
+static bool ran_in_order(const char *expect) {
+    bool same = strcmp(order, expect) == 0;
+    memset(order, 0, sizeof(order));
+    return same;
+}
+
+/**
+ * @brief Due tasks run in table order; period 0 runs every pass; the wake time is the next release.
+ */
+static void test_order(void) {
+    sched_task_t tasks[] = {
+        TASK("a", run_a, 1000, 1000),
+        TASK("b", run_b, 0, 1000),
+        TASK("c", run_c, 2000, 2000),
+    };
+    sched_t s;
+    setup(WRAP_START_US);
+    sched_init(&s, tasks, count_of(tasks), clock_now);
+    
+    // Everything is released at init
+    CHECK_EQ(sched_run(&s), WRAP_START_US + 1000);
+    CHECK(ran_in_order("abc"));
+    
+    // Between releases only the period-0 task runs
+    clock_us = WRAP_START_US + 500;
+    CHECK_EQ(sched_run(&s), WRAP_START_US + 1000);
+    CHECK(ran_in_order("b"));
+    
+    // Across the clock wrap, a is due again but c is not
+    clock_us = WRAP_START_US + 1000;
+    CHECK_EQ(sched_run(&s), WRAP_START_US + 2000);
+    CHECK(ran_in_order("ab"));
+    
+    clock_us = WRAP_START_US + 2000;
+    CHECK_EQ(sched_run(&s), WRAP_START_US + 3000);
+    CHECK(ran_in_order("abc"));
+    CHECK_EQ(tasks[0].runs, 3);
+    CHECK_EQ(tasks[1].runs, 4);
+    CHECK_EQ(tasks[2].runs, 2);
+}
+
+/**
+ * @brief A late task keeps its period grid; one a whole period behind skips the releases it missed.
+ */
+static void test_skip(void) {
+    sched_task_t tasks[] = {
+        TASK("a", run_a, 1000, 1000),
+    };
+    sched_t s;
+    setup(0);
+    sched_init(&s, tasks, count_of(tasks), clock_now);
+    
+    // Started 300us late: the next release stays on the grid
+    cost_a = 200;
+    CHECK_EQ(sched_run(&s), 1000);
+    clock_us = 1300;
+    CHECK_EQ(sched_run(&s), 2000);
+    CHECK_EQ(tasks[0].max_late_us, 300);
+    CHECK_EQ(tasks[0].misses, 0);
+    
+    // A 3.5ms run skips the three releases it overran instead of running back to back
+    clock_us = 2000;
+    cost_a = 3500;
+    CHECK_EQ(sched_run(&s), 6500);
+    clock_us = 6000;
+    sched_run(&s);
+    CHECK_EQ(tasks[0].runs, 3);
+    clock_us = 6500;
+    cost_a = 0;
+    CHECK_EQ(sched_run(&s), 7500);
+    CHECK_EQ(tasks[0].runs, 4);
+    CHECK_EQ(tasks[0].misses, 1);
+    CHECK_EQ(tasks[0].max_us, 3500);
+}
+
+/**
+ * @brief A long run delays the lower-priority tasks after it into missing their deadline.
+ */
+static void test_deadline(void) {
+    sched_task_t tasks[] = {
+        TASK("a", run_a, 1000, 1000),
+        TASK("b", run_b, 1000, 500),
+    };
+    sched_t s;
+    setup(0);
+    sched_init(&s, tasks, count_of(tasks), clock_now);
+    
+    // a's 700us run is within its own deadline but b ends 800us after release
+    cost_a = 700;
+    cost_b = 100;
+    sched_run(&s);
+    CHECK(ran_in_order("ab"));
+    CHECK_EQ(tasks[0].misses, 0);
+    CHECK_EQ(tasks[1].misses, 1);
+    CHECK_EQ(tasks[1].max_late_us, 700);
+    CHECK_EQ(tasks[1].max_us, 100);
+    
+    // On time, nothing more is missed
+    cost_a = 100;
+    clock_us = 1000;
+    sched_run(&s);
+    CHECK_EQ(tasks[1].misses, 1);
+    CHECK_EQ(tasks[0].total_us, 800);
+}
+
+/**
+ * @brief Interrupt-driven entries: sched_run() leaves them alone, sched_account() fills them in.
+ */
+static void test_account(void) {
+    sched_task_t tasks[] = {
+        TASK("a", run_a, 0, 1000),
+        TASK("tick", NULL, 1000, 200),
+    };
+    sched_t s;
+    setup(5000);
+    sched_init(&s, tasks, count_of(tasks), clock_now);
+    
+    // No run function: never run, never a wake time
+    CHECK_EQ(sched_run(&s), 5000);
+    CHECK_EQ(tasks[1].runs, 0);
+    
+    // Late and past the deadline
+    sched_task_t *t = &tasks[1];
+    sched_account(t, 1000, 1100, 1400);
+    CHECK_EQ(t->runs, 1);
+    CHECK_EQ(t->total_us, 300);
+    CHECK_EQ(t->max_us, 300);
+    CHECK_EQ(t->max_late_us, 100);
+    CHECK_EQ(t->misses, 1);
+    
+    // Started early: not late, within the deadline
+    sched_account(t, 2000, 1990, 2050);
+    CHECK_EQ(t->runs, 2);
+    CHECK_EQ(t->total_us, 360);
+    CHECK_EQ(t->max_late_us, 100);
+    CHECK_EQ(t->misses, 1);
+    
+    // Across the clock wrap
+    sched_account(t, 0xFFFFFF00u, 0x10, 0x20);
+    CHECK_EQ(t->max_late_us, 0x110);
+    CHECK_EQ(t->max_us, 300);
+    CHECK_EQ(t->misses, 2);
+}
+
+/**
+ * @brief sched_release() runs a periodic task on the next pass and restarts its grid from there.
+ */
+static void test_release(void) {
+    sched_task_t tasks[] = {
+        TASK("a", run_a, 1000, 1000),
+    };
+    sched_t s;
+    setup(0);
+    sched_init(&s, tasks, count_of(tasks), clock_now);
+    sched_run(&s);
+    CHECK(ran_in_order("a"));
+    
+    // Not due yet at 300us
+    clock_us = 300;
+    CHECK_EQ(sched_run(&s), 1000);
+    CHECK(ran_in_order(""));
+    
+    // Woken early, as core1 is by an IR edge: runs now, on time, next at 1300
+    sched_release(&tasks[0], clock_us);
+    CHECK_EQ(sched_run(&s), 1300);
+    CHECK(ran_in_order("a"));
+    CHECK_EQ(tasks[0].max_late_us, 0);
+    CHECK_EQ(tasks[0].misses, 0);
+}
+
+int main(void) {
+    test_order();
+    test_skip();
+    test_deadline();
+    test_account();
+    test_release();
+    return CHECK_DONE();
+}
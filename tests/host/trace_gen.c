@@ -0,0 +1,158 @@
+/**
+ * @file trace_gen.c
+ * @brief Write the synthetic IR trace fixtures in flight recorder dump format
+ * @author Kevin Thomas
+ * @date 2025
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Kevin Thomas
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "pico.h"
+#include "ir_wave.h"
+#include "ir.h"
+
+// Time of the first captured edge in every trace
+#define TRACE_START_US 100000
+
+// Idle time between presses
+#define TRACE_IDLE_US 40000
+
+// NEC repeat code period
+#define TRACE_REPEAT_US 108000
+
+// Address sent by the robot's remote
+#define TRACE_ADDRESS 0x00
+
+// Command bytes of every key the robot knows, in README order
+static const uint8_t trace_keys[] = {
+    0x18, 0x08, 0x1C, 0x5A, 0x52, 0x09, 0x15, 0x07, 0x0C, 0x5E, 0x42, 0x4A
+};
+
+// Protocol names, as written in "# expect" lines
+static const char *const trace_protocols[] = {
+    [IR_PROTOCOL_NONE]    = "none",
+    [IR_PROTOCOL_NEC]     = "nec",
+    [IR_PROTOCOL_NEC_EXT] = "nec-ext",
+    [IR_PROTOCOL_RC5]     = "rc5",
+    [IR_PROTOCOL_SIRC]    = "sirc",
+};
+
+// Pulse storage for a whole trace
+static fake_pulse_t trace_pulses[65536];
+
+// Frames the trace should decode to
+static ir_frame_t trace_expect[256];
+static size_t trace_expected;
+
+/**
+ * @brief Append an NEC frame and expect it.
+ */
+static void trace_nec(ir_wave_t *w, uint8_t command) {
+    ir_wave_nec(w, TRACE_ADDRESS, command);
+    trace_expect[trace_expected++] = (ir_frame_t){ IR_PROTOCOL_NEC, TRACE_ADDRESS, command, false };
+}
+
+/**
+ * @brief Append NEC repeat codes on the repeat period after a frame, and expect them.
+ */
+static void trace_repeats(ir_wave_t *w, uint64_t frame_start_us, int count) {
+    ir_frame_t repeat = trace_expect[trace_expected - 1];
+    repeat.repeat = true;
+    for (int i = 1; i <= count; i++) {
+        ir_wave_idle(w, (uint32_t)(frame_start_us + (uint64_t)i * TRACE_REPEAT_US - w->duration_us));
+        ir_wave_nec_repeat(w);
+        trace_expect[trace_expected++] = repeat;
+    }
+}
+
+/**
+ * @brief Build the named trace.
+ *
+ * @param name  The trace name.
+ * @param w     Receives the waveform.
+ * @return bool  false if there is no trace by that name.
+ */
+static bool trace_build(const char *name, ir_wave_t *w) {
+    if (strcmp(name, "nec_press") == 0) {
+        // One clean forward press
+        ir_wave_init(w, trace_pulses, count_of(trace_pulses), NULL);
+        trace_nec(w, 0x18);
+    } else if (strcmp(name, "nec_hold") == 0) {
+        // Backward held for half a second: a frame, then repeat codes
+        ir_wave_init(w, trace_pulses, count_of(trace_pulses), &(ir_wave_impair_t){ 1.0, 15, 0, 11 });
+        trace_nec(w, 0x52);
+        trace_repeats(w, 0, 4);
+    } else if (strcmp(name, "nec_keys") == 0) {
+        // Every key once, from a remote running 4% slow with jittery pulses
+        ir_wave_init(w, trace_pulses, count_of(trace_pulses), &(ir_wave_impair_t){ 1.04, 40, 0, 12 });
+        for (size_t i = 0; i < count_of(trace_keys); i++) {
+            if (i) ir_wave_idle(w, TRACE_IDLE_US);
+            trace_nec(w, trace_keys[i]);
+        }
+    } else if (strcmp(name, "nec_glitch") == 0) {
+        // Forward, left, right, stop held with repeats, all hit by receiver glitches
+        ir_wave_init(w, trace_pulses, count_of(trace_pulses), &(ir_wave_impair_t){ 1.0, 20, 0.02, 13 });
+        static const uint8_t keys[] = { 0x18, 0x08, 0x5A, 0x1C };
+        for (size_t i = 0; i < count_of(keys); i++) {
+            if (i) ir_wave_idle(w, TRACE_IDLE_US);
+            uint64_t start = w->duration_us;
+            trace_nec(w, keys[i]);
+            trace_repeats(w, start, 2);
+        }
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Write one trace to stdout.
+ *
+ * Usage: trace_gen <name>, with name one of nec_press, nec_hold, nec_keys or
+ * nec_glitch. The output is a recorder dump ("E <us> <edge word>") preceded
+ * by one "# expect <protocol> <address> <command> [repeat]" line per frame.
+ */
+int main(int argc, char **argv) {
+    ir_wave_t w;
+    if (argc != 2 || !trace_build(argv[1], &w)) {
+        fprintf(stderr, "usage: trace_gen nec_press|nec_hold|nec_keys|nec_glitch\n");
+        return 1;
+    }
+    
+    // Expected frames, then the edges with the time each pulse ended
+    printf("# %s: generated by tests/host/trace_gen\n", argv[1]);
+    for (size_t i = 0; i < trace_expected; i++)
+        printf("# expect %s %04x %02x%s\n", trace_protocols[trace_expect[i].protocol],
+               trace_expect[i].address, trace_expect[i].command, trace_expect[i].repeat ? " repeat" : "");
+    
+    uint32_t edges[count_of(trace_pulses)];
+    size_t n = ir_wave_edges(&w, edges, count_of(edges));
+    uint64_t t = TRACE_START_US;
+    for (size_t i = 0; i < n; i++) {
+        t += edges[i] & IR_EDGE_HIGH ? ~edges[i] : edges[i];
+        printf("E %lu %08lx\n", (unsigned long)t, (unsigned long)edges[i]);
+    }
+    return 0;
+}
@@ -0,0 +1,84 @@
+/**
+ * @file ir_replay.c
+ * @brief Replay a flight recorder dump through the IR decoder on a host
+ * @author Kevin Thomas
+ * @date 2025
+ *
+ * MIT License
+ *
+ * Copyright (c) 2025 Kevin Thomas
+ *
+ * See the LICENSE file in the repository root for the full license text.
+ *
+ * Reads the output of the USB 'r' command (see recorder.h) and feeds every
+ * recorded edge word to the same decoder the robot runs, printing the frames
+ * and key events it produces next to the key events the robot recorded.
+ *
+ * Build and run from the repository root:
+ *     cc -I. -o ir_replay tools/ir_replay.c ir_decode.c
+ *     ./ir_replay < dump.txt
+ */
+
+#include <stdio.h>
+#include "ir.h"
+
+static const char *const protocol_names[IR_PROTOCOL_COUNT] = {
+    [IR_PROTOCOL_NONE]    = "none",
+    [IR_PROTOCOL_NEC]     = "nec",
+    [IR_PROTOCOL_NEC_EXT] = "nec-ext",
+    [IR_PROTOCOL_RC5]     = "rc5",
+    [IR_PROTOCOL_SIRC]    = "sirc",
+};
+
+static const char *const event_names[] = { "none", "press", "hold", "release" };
+
+int main(void) {
+    ir_decoder_t dec;
+    ir_decoder_reset(&dec);
+    ir_key_state_t ks = { -1, 0 };
+    uint32_t last_edge_us = 0;
+    unsigned long replayed = 0, recorded = 0;
+    
+    char line[80];
+    while (fgets(line, sizeof(line), stdin)) {
+        unsigned long time_us, value;
+        unsigned int type, key;
+        ir_frame_t frame;
+        bool done = false;
+        
+        if (sscanf(line, "E %lu %lx", &time_us, &value) == 2) {
+            // End a frame followed by silence, as ir_poll() does on the robot
+            if (!ir_decoder_idle(&dec) && (uint32_t)time_us - last_edge_us >= IR_GAP_US)
+                done = ir_decode_edge(&dec, ~(uint32_t)IR_GAP_US, &frame);
+            if (!done) done = ir_decode_edge(&dec, (uint32_t)value, &frame);
+            last_edge_us = (uint32_t)time_us;
+        } else if (sscanf(line, "K %lu %u %x", &time_us, &type, &key) == 3) {
+            // What the robot acted on, for comparison
+            if (type == IR_EVENT_PRESS) recorded++;
+            printf("%10lu recorded %-7s %02x\n", time_us, type < 4 ? event_names[type] : "?", key);
+            continue;
+        } else if (line[0] == 'S' || line[0] == '#') {
+            // Sector boundaries and comments pass through
+            fputs(line, stdout);
+            continue;
+        } else {
+            continue;
+        }
+        
+        // Track the key on the recorded timeline
+        if (done)
+            printf("%10lu frame    %-7s addr %04x cmd %02x%s\n", time_us,
+                   frame.protocol < IR_PROTOCOL_COUNT ? protocol_names[frame.protocol] : "?",
+                   frame.address, frame.command, frame.repeat ? " repeat" : "");
+        ir_event_t ev = ir_track_key(&ks, done ? &frame : NULL, (uint32_t)time_us);
+        if (ev.type != IR_EVENT_NONE) {
+            if (ev.type == IR_EVENT_PRESS) replayed++;
+            printf("%10lu replayed %-7s %02x\n", time_us, event_names[ev.type], ev.key);
+        }
+    }
+    
+    // Decoder statistics for the whole trace
+    printf("# presses replayed %lu, recorded %lu; frames %lu, glitches %lu\n",
+           replayed, recorded, (unsigned long)dec.stats.frames, (unsigned long)dec.stats.glitches);
+    return replayed == recorded ? 0 : 1;
+}
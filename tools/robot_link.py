@@ -0,0 +1,278 @@
+#!/usr/bin/env python3
+"""
+@file robot_link.py
+@brief Host tool for the C-Robot binary USB control protocol
+@author Kevin Thomas
+@date 2025
+
+MIT License
+
+Copyright (c) 2025 Kevin Thomas
+
+See the LICENSE file in the repository root for the full license text.
+
+Frames are: type (u8), sequence (u8), body, CRC-16/CCITT-FALSE (u16, LE),
+COBS encoded and sent between two 0x00 delimiters. See link.h.
+
+Usage:
+    robot_link.py PORT drive LEFT RIGHT [--rate HZ] [--seconds S]
+    robot_link.py PORT arcade THROTTLE TURN [--rate HZ] [--seconds S]
+    robot_link.py PORT heartbeat [--rate HZ] [--seconds S]
+    robot_link.py PORT brake MS
+    robot_link.py PORT telemetry
+    robot_link.py sim
+
+PORT is the robot's USB serial device (e.g. /dev/ttyACM0). "sim" opens a
+pseudo-terminal that answers like the robot and prints its path, so the
+other commands can be tried without hardware.
+"""
+
+import argparse
+import os
+import select
+import struct
+import sys
+import termios
+import time
+import tty
+
+MSG_DRIVE = 0x01
+MSG_HEARTBEAT = 0x02
+MSG_BRAKE = 0x03
+MSG_TELEMETRY = 0x04
+MSG_ARCADE = 0x05
+REPLY_TELEMETRY = 0x84
+
+FLAG_FAILSAFE = 0x01
+FLAG_MOTION = 0x02
+
+FAILSAFE_S = 0.8
+
+
+def crc16(data):
+    """CRC-16/CCITT-FALSE, poly 0x1021, init 0xFFFF."""
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_encode(data):
+    """COBS encode data (no delimiter)."""
+    out = bytearray([0])
+    code_idx, code = 0, 1
+    for b in data:
+        if b:
+            out.append(b)
+            code += 1
+        if not b or code == 0xFF:
+            out[code_idx] = code
+            code_idx, code = len(out), 1
+            out.append(0)
+    out[code_idx] = code
+    return bytes(out)
+
+
+def cobs_decode(data):
+    """COBS decode data (no delimiter), or None if invalid."""
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        i += 1
+        if code == 0 or i + code - 1 > len(data):
+            return None
+        out += data[i:i + code - 1]
+        i += code - 1
+        if code != 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def build_frame(msg, seq, body=b""):
+    """Wire bytes for one frame, delimiters included."""
+    frame = bytes([msg, seq & 0xFF]) + body
+    frame += struct.pack("<H", crc16(frame))
+    return b"\0" + cobs_encode(frame) + b"\0"
+
+
+def parse_frame(encoded):
+    """(type, seq, body) from the bytes between delimiters, or None."""
+    frame = cobs_decode(encoded)
+    if frame is None or len(frame) < 4:
+        return None
+    if struct.unpack("<H", frame[-2:])[0] != crc16(frame[:-2]):
+        return None
+    return frame[0], frame[1], frame[2:-2]
+
+
+class Reader:
+    """Splits a byte stream into frames and text, like link_poll()."""
+
+    def __init__(self):
+        self.framed = False
+        self.buf = bytearray()
+        self.text = bytearray()
+
+    def feed(self, data):
+        """Return the frames completed by data; text is collected in self.text."""
+        frames = []
+        for b in data:
+            if b == 0:
+                # Every delimiter ends the frame before it; one right after that frame opens the next
+                closing = bool(self.buf)
+                if closing:
+                    frames.append(parse_frame(bytes(self.buf)))
+                self.buf.clear()
+                self.framed = not closing
+                continue
+            self.buf.append(b)
+
+            # A whole printable line outside a frame is text
+            if b in b"\r\n" and not self.framed and all(c in b"\t\r\n" or 0x20 <= c <= 0x7E for c in self.buf):
+                self.text += self.buf
+                self.buf.clear()
+        return frames
+
+
+def open_port(path):
+    """Open a serial device or pty in raw mode."""
+    fd = os.open(path, os.O_RDWR | os.O_NOCTTY)
+    tty.setraw(fd)
+    return fd
+
+
+def read_reply(fd, reader, want, timeout=0.5):
+    """Wait for a reply frame of type want."""
+    end = time.monotonic() + timeout
+    while time.monotonic() < end:
+        ready, _, _ = select.select([fd], [], [], end - time.monotonic())
+        if not ready:
+            break
+        for frame in reader.feed(os.read(fd, 256)):
+            if frame and frame[0] == want:
+                return frame
+    return None
+
+
+def print_telemetry(body):
+    """Decode and print a telemetry body."""
+    t, left, right, flags, frames, errors = struct.unpack("<IhhBHH", body)
+    print("time %u us, duty %d/%d, frames %u, errors %u%s%s" % (
+        t, left * 2, right * 2, frames, errors,
+        ", failsafe" if flags & FLAG_FAILSAFE else "",
+        ", motion" if flags & FLAG_MOTION else ""))
+
+
+def stream(fd, msg, body, rate, seconds):
+    """Send the same frame at a fixed rate and report the achieved rate."""
+    period = 1.0 / rate
+    start = next_t = time.monotonic()
+    seq = 0
+    while time.monotonic() - start < seconds:
+        os.write(fd, build_frame(msg, seq, body))
+        seq += 1
+        next_t += period
+        delay = next_t - time.monotonic()
+        if delay > 0:
+            time.sleep(delay)
+    elapsed = time.monotonic() - start
+    print("sent %d frames in %.2f s (%.0f Hz)" % (seq, elapsed, seq / elapsed))
+
+
+def simulate():
+    """Answer like the robot on a pty until interrupted."""
+    master, slave = os.openpty()
+    tty.setraw(slave)
+    print(os.ttyname(slave), flush=True)
+
+    reader = Reader()
+    left = right = 0
+    frames = errors = 0
+    last_cmd = 0.0
+    start = time.monotonic()
+    while True:
+        ready, _, _ = select.select([master], [], [], 0.1)
+        if not ready:
+            continue
+        for frame in reader.feed(os.read(master, 1024)):
+            ok = True
+            if frame is None:
+                ok = False
+            elif frame[0] == MSG_DRIVE and len(frame[2]) == 4:
+                l, r = struct.unpack("<hh", frame[2])
+                left, right, last_cmd = l * 2, r * 2, time.monotonic()
+            elif frame[0] == MSG_ARCADE and len(frame[2]) == 4:
+                t, turn = (v * 2 for v in struct.unpack("<hh", frame[2]))
+                l, r = t + turn, t - turn
+                peak = max(abs(l), abs(r))
+                if peak > 65535:
+                    l, r = int(l * 65535 / peak), int(r * 65535 / peak)
+                left, right, last_cmd = l, r, time.monotonic()
+            elif frame[0] == MSG_HEARTBEAT and not frame[2]:
+                last_cmd = time.monotonic()
+            elif frame[0] == MSG_BRAKE and len(frame[2]) == 2:
+                left = right = 0
+                last_cmd = time.monotonic()
+            elif frame[0] == MSG_TELEMETRY and not frame[2]:
+                tripped = time.monotonic() - last_cmd > FAILSAFE_S
+                if tripped:
+                    left = right = 0
+                body = struct.pack("<IhhBHH",
+                                   int((time.monotonic() - start) * 1e6) & 0xFFFFFFFF,
+                                   left // 2, right // 2,
+                                   FLAG_FAILSAFE if tripped else 0,
+                                   (frames + 1) & 0xFFFF, errors & 0xFFFF)
+                os.write(master, build_frame(REPLY_TELEMETRY, frame[1], body))
+            else:
+                ok = False
+            if ok:
+                frames += 1
+            else:
+                errors += 1
+
+
+def main():
+    parser = argparse.ArgumentParser(description="C-Robot binary USB control")
+    parser.add_argument("port", help="serial device, or 'sim' for a pty stand-in")
+    parser.add_argument("command", nargs="?", choices=["drive", "arcade", "heartbeat", "brake", "telemetry"])
+    parser.add_argument("args", nargs="*", type=int)
+    parser.add_argument("--rate", type=float, default=500.0, help="frames per second")
+    parser.add_argument("--seconds", type=float, default=1.0, help="how long to stream")
+    opts = parser.parse_args()
+
+    if opts.port == "sim":
+        try:
+            simulate()
+        except KeyboardInterrupt:
+            pass
+        return 0
+
+    fd = open_port(opts.port)
+    reader = Reader()
+    if opts.command in ("drive", "arcade") and len(opts.args) == 2:
+        body = struct.pack("<hh", *(max(-32767, min(32767, v // 2)) for v in opts.args))
+        stream(fd, MSG_DRIVE if opts.command == "drive" else MSG_ARCADE, body, opts.rate, opts.seconds)
+    elif opts.command == "heartbeat":
+        stream(fd, MSG_HEARTBEAT, b"", opts.rate, opts.seconds)
+    elif opts.command == "brake" and len(opts.args) == 1:
+        os.write(fd, build_frame(MSG_BRAKE, 0, struct.pack("<H", opts.args[0])))
+    elif opts.command == "telemetry":
+        termios.tcflush(fd, termios.TCIFLUSH)
+        os.write(fd, build_frame(MSG_TELEMETRY, 0))
+        reply = read_reply(fd, reader, REPLY_TELEMETRY)
+        if reply is None:
+            print("no reply", file=sys.stderr)
+            return 1
+        print_telemetry(reply[2])
+    else:
+        parser.print_usage(sys.stderr)
+        return 2
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())